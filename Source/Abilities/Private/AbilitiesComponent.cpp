@@ -1,17 +1,38 @@
 // Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
 
 #include "AbilitiesComponent.h"
+#include <Algo/Find.h>
 #include <Engine/ActorChannel.h>
 #include <Engine/World.h>
 #include <GameFramework/Controller.h>
 #include <Kismet/KismetSystemLibrary.h>
 #include <Net/UnrealNetwork.h>
 
+#include "AbilitiesSnapshot.h"
+#include "AbilitiesWorldSubsystem.h"
 
-void UAbilitiesComponent::OnRep_Tags()
+
+void UAbilitiesComponent::OnRep_Tags(const FGameplayTagContainer& PreviousTags)
 {
 	if(!HasAuthority())
 	{
+		// Clients only know the explicit tags
+		TagCounts.Reset(Tags);
+
+		for (const FGameplayTag& Tag : Tags)
+		{
+			if (!PreviousTags.HasTagExact(Tag))
+			{
+				PendingTagsDelta.Add(Tag);
+			}
+		}
+		for (const FGameplayTag& Tag : PreviousTags)
+		{
+			if (!Tags.HasTagExact(Tag))
+			{
+				PendingTagsDelta.Remove(Tag);
+			}
+		}
 		NotifyTagsChanged();
 	}
 }
@@ -32,6 +53,7 @@ void UAbilitiesComponent::Activate(bool bReset /*= false*/)
 		ApplyBuffs(InitialBuffs);
 		EquipAbilities(InitialAbilities);
 	}
+	UpdateTickRegistration();
 }
 
 void UAbilitiesComponent::Deactivate()
@@ -50,6 +72,7 @@ void UAbilitiesComponent::Deactivate()
 		bIsTearingDown = false;
 	}
 	Super::Deactivate();
+	UpdateTickRegistration();
 }
 
 void UAbilitiesComponent::OnRegister()
@@ -58,6 +81,45 @@ void UAbilitiesComponent::OnRegister()
 
 	Cooldowns.Setup(*this);
 	BuffLifetimes.Setup(*this);
+	ReplicatedBuffs.Setup(*this);
+	OwnerReplicatedBuffs.Setup(*this);
+	// Default tags are granted once. Registering again keeps the grants of buffs and abilities.
+	TagCounts.GrantMissing(Tags);
+	for (const auto& Attribute : BaseAttributes)
+	{
+		Attributes.SetBaseValue(Attribute.Key, Attribute.Value);
+	}
+	UpdateTickRegistration();
+}
+
+void UAbilitiesComponent::OnUnregister()
+{
+	if (bBuffFlushPending)
+	{
+		FlushDeferredBuffs();
+	}
+
+	UWorld* World = GetWorld();
+	if (auto* Subsystem = World? World->GetSubsystem<UAbilitiesWorldSubsystem>() : nullptr)
+	{
+		if (SubsystemTickIndex != INDEX_NONE)
+		{
+			Subsystem->Unregister(*this);
+		}
+
+		if (Subsystem->GetNumPeriodicBuffs() > 0)
+		{
+			Buffs.ForEachSlot([this, Subsystem](int32 Slot)
+			{
+				const UBuff* Buff = Buffs.GetBuff(Slot);
+				if (Buff->GetPeriod() > 0.f)
+				{
+					Subsystem->RemovePeriodicBuff(*this, *Buff);
+				}
+			});
+		}
+	}
+	Super::OnUnregister();
 }
 
 void UAbilitiesComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
@@ -66,11 +128,45 @@ void UAbilitiesComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 	Super::EndPlay(EndPlayReason);
 }
 
+void UAbilitiesComponent::RegisterComponentTickFunctions(bool bRegister)
+{
+	// Batched components don't need their own tick function
+	if (!bRegister || !bTickWithSubsystem)
+	{
+		Super::RegisterComponentTickFunctions(bRegister);
+	}
+}
+
 void UAbilitiesComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	BatchedTick(DeltaTime);
+}
+
+void UAbilitiesComponent::SetTickWithSubsystem(bool bEnabled)
+{
+	if (bTickWithSubsystem == bEnabled)
+	{
+		return;
+	}
+	bTickWithSubsystem = bEnabled;
+
+	if (IsRegistered())
+	{
+		// Swap tick function for the subsystem or the other way around
+		RegisterComponentTickFunctions(!bTickWithSubsystem);
+		if (!bTickWithSubsystem)
+		{
+			SetComponentTickEnabled(IsActive());
+		}
+		UpdateTickRegistration();
+	}
+}
 
+void UAbilitiesComponent::BatchedTick(float DeltaTime)
+{
 	BuffLifetimes.Tick();
+	Cooldowns.Tick();
 
 	for (auto* Ability : TickingAbilities)
 	{
@@ -81,6 +177,46 @@ void UAbilitiesComponent::TickComponent(float DeltaTime, enum ELevelTick TickTyp
 	}
 }
 
+bool UAbilitiesComponent::HasTickWork() const
+{
+	return TickingAbilities.Num() > 0 || BuffLifetimes.HasPending() || Cooldowns.HasPending();
+}
+
+void UAbilitiesComponent::UpdateTickRegistration()
+{
+	const bool bWantsTick = bTickWithSubsystem && IsRegistered() && IsActive() && HasTickWork();
+	const bool bIsRegistered = SubsystemTickIndex != INDEX_NONE;
+	if (bWantsTick == bIsRegistered)
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+	if (auto* Subsystem = World? World->GetSubsystem<UAbilitiesWorldSubsystem>() : nullptr)
+	{
+		if (bWantsTick)
+		{
+			Subsystem->Register(*this);
+		}
+		else
+		{
+			Subsystem->Unregister(*this);
+		}
+	}
+}
+
+void UAbilitiesComponent::AddTickingAbility(UAbility* Ability)
+{
+	TickingAbilities.Add(Ability);
+	UpdateTickRegistration();
+}
+
+void UAbilitiesComponent::RemoveTickingAbility(UAbility* Ability)
+{
+	TickingAbilities.Remove(Ability);
+	UpdateTickRegistration();
+}
+
 bool UAbilitiesComponent::ReplicateSubobjects(UActorChannel* Channel, class FOutBunch* Bunch, FReplicationFlags* RepFlags)
 {
 	bool bWroteSomething = Super::ReplicateSubobjects(Channel, Bunch, RepFlags);
@@ -98,6 +234,7 @@ bool UAbilitiesComponent::ReplicateSubobjects(UActorChannel* Channel, class FOut
 		{
 			// Purge unequipped abilities
 			AllAbilities.RemoveAtSwap(I, 1, false);
+			bAvailabilitySlotsDirty = true;
 			--I;
 		}
 	}
@@ -110,6 +247,11 @@ void UAbilitiesComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>&
 
 	DOREPLIFETIME(UAbilitiesComponent, Tags);
 	DOREPLIFETIME(UAbilitiesComponent, AllAbilities);
+
+	// Each buff picks a list depending on its policy
+	DOREPLIFETIME(UAbilitiesComponent, ReplicatedBuffs);
+	DOREPLIFETIME_CONDITION(UAbilitiesComponent, OwnerReplicatedBuffs, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(UAbilitiesComponent, PredictionAcks, COND_OwnerOnly);
 }
 
 void UAbilitiesComponent::EquipAbility(TSubclassOf<UAbility> Class)
@@ -172,17 +314,13 @@ void UAbilitiesComponent::UnequipAbility(TSubclassOf<UAbility> Class)
 		return;
 	}
 
-	UAbility* Ability = GetEquippedAbility(Class.Get());
-	if (!Ability)
+	if (!GetEquippedAbility(Class.Get()))
 	{
 		UE_LOG(LogAbilities, Log, TEXT("Ability %s not equipped."), *Class->GetName());
 		return;
 	}
 
-	Ability->DoEndPlay();
-
-	AbilityToInstance.Remove(Class);
-	EquippedAbilities.Remove(Class);
+	InternalUnequipAbilities(MakeArrayView(&Class, 1));
 }
 
 void UAbilitiesComponent::UnequipAbilities()
@@ -192,10 +330,28 @@ void UAbilitiesComponent::UnequipAbilities()
 		return;
 	}
 
-	TArray<TSubclassOf<UAbility>> CachedEquipped = EquippedAbilities.Array();
-	for (const auto& Class : CachedEquipped)
+	InternalUnequipAbilities(EquippedAbilities.Array());
+}
+
+void UAbilitiesComponent::InternalUnequipAbilities(TArrayView<const TSubclassOf<UAbility>> Classes)
+{
+	TSet<const UAbilityBase*> Unequipped;
+	Unequipped.Reserve(Classes.Num());
+	for (const auto& Class : Classes)
+	{
+		if (UAbility* Ability = GetEquippedAbility(Class.Get()))
+		{
+			Ability->DoEndPlay();
+			Unequipped.Add(Ability);
+			AbilityToInstance.Remove(Class);
+			EquippedAbilities.Remove(Class);
+		}
+	}
+
+	if (Unequipped.Num() > 0)
 	{
-		UnequipAbility(Class.Get());
+		PredictionAcks.RemoveAll([&Unequipped](const FBuffPredictionKey& Ack) { return Unequipped.Contains(Ack.Ability); });
+		bAvailabilitySlotsDirty = true;
 	}
 }
 
@@ -206,20 +362,125 @@ bool UAbilitiesComponent::IsEquipped(TSubclassOf<UAbility> AbilityClass) const
 
 bool UAbilitiesComponent::CanCast(TSubclassOf<UAbility> Class, FStructContainer Container)
 {
-	if (UAbility* Ability = GetEquippedAbility(Class))
+	UAbility* Ability = GetEquippedAbility(Class);
+	if (!Ability)
 	{
-		return Ability->CanCast(Container);
+		return false;
 	}
-	return false;
+
+	if (bCacheAvailability && Container.Num() <= 0)
+	{
+		UpdateAvailability();
+		if (Availability.Castable.IsValidIndex(Ability->AvailabilitySlot))
+		{
+			return Availability.Castable[Ability->AvailabilitySlot];
+		}
+	}
+	return Ability->CanCast(Container);
 }
 
 bool UAbilitiesComponent::CanActivate(TSubclassOf<UAbility> Class, FStructContainer Container)
 {
-	if (UAbility* Ability = GetEquippedAbility(Class))
+	UAbility* Ability = GetEquippedAbility(Class);
+	if (!Ability)
 	{
-		return Ability->CanActivate(Container);
+		return false;
 	}
-	return false;
+
+	if (bCacheAvailability && Container.Num() <= 0)
+	{
+		UpdateAvailability();
+		if (Availability.Activatable.IsValidIndex(Ability->AvailabilitySlot))
+		{
+			return Availability.Activatable[Ability->AvailabilitySlot];
+		}
+	}
+	return Ability->CanActivate(Container);
+}
+
+TArray<UAbility*> UAbilitiesComponent::GetCastableAbilities()
+{
+	TArray<UAbility*> Abilities;
+	GetCastableAbilities(Abilities);
+	return Abilities;
+}
+
+void UAbilitiesComponent::GetCastableAbilities(TArray<UAbility*>& OutAbilities)
+{
+	OutAbilities.Reset();
+	if (bCacheAvailability)
+	{
+		UpdateAvailability();
+		for (TConstSetBitIterator<> It{ Availability.Castable }; It; ++It)
+		{
+			OutAbilities.Add(AllAbilities[It.GetIndex()]);
+		}
+		return;
+	}
+
+	for (UAbility* Ability : AllAbilities)
+	{
+		if (IsEquippedInstance(Ability) && CheckCanCast(*Ability, {}))
+		{
+			OutAbilities.Add(Ability);
+		}
+	}
+}
+
+void UAbilitiesComponent::InvalidateAvailability()
+{
+	Availability.InvalidateAll();
+}
+
+void UAbilitiesComponent::InvalidateAvailability(const UAbility& Ability)
+{
+	if (!bAvailabilitySlotsDirty)
+	{
+		Availability.Invalidate(Ability.AvailabilitySlot);
+	}
+}
+
+void UAbilitiesComponent::UpdateAvailability()
+{
+	if (bAvailabilitySlotsDirty || Availability.Num() != AllAbilities.Num())
+	{
+		bAvailabilitySlotsDirty = false;
+		Availability.Reset(AllAbilities.Num());
+		for (int32 I = 0; I < AllAbilities.Num(); ++I)
+		{
+			if (UAbility* Ability = AllAbilities[I])
+			{
+				Ability->AvailabilitySlot = I;
+			}
+		}
+	}
+
+	for (TConstSetBitIterator<> It{ Availability.Dirty }; It; ++It)
+	{
+		const int32 Slot = It.GetIndex();
+		UAbility* Ability = AllAbilities[Slot];
+		const bool bValid = IsEquippedInstance(Ability);
+		Availability.Set(Slot,
+			bValid && CheckCanCast(*Ability, {}),
+			bValid && CheckCanActivate(*Ability, {}));
+	}
+}
+
+bool UAbilitiesComponent::IsEquippedInstance(const UAbility* Ability)
+{
+	// Unequipped instances stay in AllAbilities until they are purged on replication
+	return IsValid(Ability) && Ability->GetState() != EAbilityState::AfterEndPlay;
+}
+
+bool UAbilitiesComponent::CheckCanCast(UAbility& Ability, const FStructContainer& Container)
+{
+	const EAbilityState Destination = Ability.bHasCast? EAbilityState::Cast : EAbilityState::Activation;
+	return Ability.CanTransition({ Ability.GetState(), Destination }, Container);
+}
+
+bool UAbilitiesComponent::CheckCanActivate(UAbility& Ability, const FStructContainer& Container)
+{
+	return Ability.CanTransition({ Ability.GetState(), EAbilityState::Activation }, Container);
 }
 
 bool UAbilitiesComponent::IsRunning(TSubclassOf<UAbility> Class) const
@@ -254,6 +515,7 @@ float UAbilitiesComponent::GetBuffRemainingLifetime(UBuff* Buff) const
 
 void UAbilitiesComponent::OnRep_AllAbilities()
 {
+	bAvailabilitySlotsDirty = true;
 	AbilityToInstance.Empty(AllAbilities.Num());
 	AbilityToInstance.Reserve(AllAbilities.Num());
 	for (auto* Ability : AllAbilities)
@@ -391,32 +653,46 @@ void UAbilitiesComponent::InternalEquipAbility(UClass* Class)
 
 	AllAbilities.Add(Ability);
 	AbilityToInstance.Add(Class, Ability);
+	bAvailabilitySlotsDirty = true;
 
 	Ability->DoBeginPlay(this);
 }
 
 void UAbilitiesComponent::AddTag(const FGameplayTag& NewTag)
 {
-	if (NewTag.IsValid())
+	if (NewTag.IsValid() && TagCounts.Grant(NewTag))
 	{
 		Tags.AddTag(NewTag);
+		PendingTagsDelta.Add(NewTag);
 		NotifyTagsChanged();
 	}
 }
 
 void UAbilitiesComponent::AddTags(const FGameplayTagContainer& NewTags)
 {
-	if(NewTags.Num() > 0)
+	bool bAddedAny = false;
+	for (const FGameplayTag& NewTag : NewTags)
+	{
+		if (TagCounts.Grant(NewTag))
+		{
+			Tags.AddTag(NewTag);
+			PendingTagsDelta.Add(NewTag);
+			bAddedAny = true;
+		}
+	}
+
+	if (bAddedAny)
 	{
-		Tags.AppendTags(NewTags);
 		NotifyTagsChanged();
 	}
 }
 
 bool UAbilitiesComponent::RemoveTag(const FGameplayTag& NewTag)
 {
-	if (NewTag.IsValid() && Tags.RemoveTag(NewTag))
+	if (NewTag.IsValid() && TagCounts.Revoke(NewTag))
 	{
+		Tags.RemoveTag(NewTag);
+		PendingTagsDelta.Remove(NewTag);
 		NotifyTagsChanged();
 		return true;
 	}
@@ -425,28 +701,164 @@ bool UAbilitiesComponent::RemoveTag(const FGameplayTag& NewTag)
 
 void UAbilitiesComponent::RemoveTags(const FGameplayTagContainer& NewTags)
 {
-	if(NewTags.Num() > 0)
+	bool bRemovedAny = false;
+	for (const FGameplayTag& Tag : NewTags)
+	{
+		// Parent tags are updated once at the end
+		if (TagCounts.Revoke(Tag) && Tags.RemoveTag(Tag, true))
+		{
+			PendingTagsDelta.Remove(Tag);
+			bRemovedAny = true;
+		}
+	}
+
+	if (bRemovedAny)
+	{
+		Tags.FillParentTags();
+		NotifyTagsChanged();
+	}
+}
+
+void UAbilitiesComponent::ApplyTagChanges(TArrayView<const FGameplayTag> Grants, TArrayView<const FGameplayTag> Revokes)
+{
+	bool bChanged = false;
+	for (const FGameplayTag& Tag : Grants)
+	{
+		if (TagCounts.Grant(Tag))
+		{
+			Tags.AddTag(Tag);
+			PendingTagsDelta.Add(Tag);
+			bChanged = true;
+		}
+	}
+
+	bool bRemovedAny = false;
+	for (const FGameplayTag& Tag : Revokes)
+	{
+		// Parent tags are updated once at the end
+		if (TagCounts.Revoke(Tag) && Tags.RemoveTag(Tag, true))
+		{
+			PendingTagsDelta.Remove(Tag);
+			bRemovedAny = true;
+		}
+	}
+
+	if (bRemovedAny)
+	{
+		Tags.FillParentTags();
+	}
+	if (bChanged || bRemovedAny)
 	{
-		Tags.RemoveTags(NewTags);
 		NotifyTagsChanged();
 	}
 }
 
+int32 UAbilitiesComponent::GetTagCount(const FGameplayTag& Tag) const
+{
+	return TagCounts.GetCount(Tag);
+}
+
 void UAbilitiesComponent::NotifyTagsChanged()
 {
+	if (TagMutationDepth > 0)
+	{
+		bPendingTagsChanged = true;
+		return;
+	}
+	bPendingTagsChanged = false;
+	BroadcastTagsChanged();
+}
+
+void UAbilitiesComponent::BroadcastTagsChanged()
+{
+	// Changes done by listeners will be notified separately
+	const FAbilityTagsDelta Delta = MoveTemp(PendingTagsDelta);
+	PendingTagsDelta.Reset();
+
+	if (Delta.IsEmpty())
+	{
+		return;
+	}
+
+	InvalidateAvailability();
+
+	OnTagsDelta.Broadcast(Delta);
 	OnTagsChanged.Broadcast();
 
 	for(auto* Ability : AllAbilities)
 	{
 		if(ensure(Ability))
 		{
+			Ability->OnTagsDelta(Delta);
 			Ability->OnTagsChanged(Tags);
 		}
 	}
+
+	// Only running abilities listening to a received tag can be interrupted
+	TArray<UAbility*, TInlineAllocator<4>> InterruptedAbilities;
+	if (InterruptListeners.Num() > 0)
+	{
+		for (const FGameplayTag& Tag : Delta.Added)
+		{
+			if (const auto* Listeners = InterruptListeners.Find(Tag))
+			{
+				for (UAbility* Ability : *Listeners)
+				{
+					InterruptedAbilities.AddUnique(Ability);
+				}
+			}
+		}
+	}
+
+	for (UAbility* Ability : InterruptedAbilities)
+	{
+		// May have been interrupted by another ability
+		if (Ability->bListensToInterrupts)
+		{
+			Ability->Cancel(true);
+		}
+	}
+}
+
+void UAbilitiesComponent::AddInterruptListener(UAbility& Ability)
+{
+	if (Ability.bListensToInterrupts || Ability.InterruptWithTags.Num() <= 0)
+	{
+		return;
+	}
+
+	Ability.bListensToInterrupts = true;
+	for (const FGameplayTag& Tag : Ability.InterruptWithTags)
+	{
+		InterruptListeners.FindOrAdd(Tag).Add(&Ability);
+	}
+}
+
+void UAbilitiesComponent::RemoveInterruptListener(UAbility& Ability)
+{
+	if (!Ability.bListensToInterrupts)
+	{
+		return;
+	}
+
+	Ability.bListensToInterrupts = false;
+	for (const FGameplayTag& Tag : Ability.InterruptWithTags)
+	{
+		if (auto* Listeners = InterruptListeners.Find(Tag))
+		{
+			Listeners->RemoveSingleSwap(&Ability, false);
+			if (Listeners->Num() <= 0)
+			{
+				InterruptListeners.Remove(Tag);
+			}
+		}
+	}
 }
 
 bool UAbilitiesComponent::ApplyBuffs(const TSet<FBuffCount>& InBuffs)
 {
+	NotifyDeferredBuffs();
+
 	TSet<FBuffCount> AppliedBuffs{};
 	if (HasAuthority() && InternalApplyBuffs(InBuffs, AppliedBuffs))
 	{
@@ -456,6 +868,20 @@ bool UAbilitiesComponent::ApplyBuffs(const TSet<FBuffCount>& InBuffs)
 	return false;
 }
 
+bool UAbilitiesComponent::ApplyBuffSpec(const FBuffSpec& Spec, int32 Count)
+{
+	NotifyDeferredBuffs();
+
+	TSet<FBuffCount> AppliedBuffs{};
+	if (HasAuthority() && Spec.Buff && Count > 0 &&
+		InternalApplyBuffs({ FBuffCount{ Spec.Buff, Count } }, AppliedBuffs, &Spec))
+	{
+		NotifyBuffsChanged(AppliedBuffs, EBuffOperation::Added);
+		return true;
+	}
+	return false;
+}
+
 bool UAbilitiesComponent::ApplySingleBuffs(const TSet<UBuff*>& InBuffs)
 {
 	TSet<FBuffCount> InBuffCounts;
@@ -471,14 +897,27 @@ bool UAbilitiesComponent::ResetBuffs()
 {
 	if (HasAuthority())
 	{
-		TSet<FBuffCount> RemovedBuffs = Buffs;
-		BuffsByClass.Empty();
-		Buffs.Empty();
+		NotifyDeferredBuffs();
 
-		for (const FBuffCount& BuffCount : Buffs)
+		TSet<FBuffCount> RemovedBuffs;
+		RemovedBuffs.Reserve(Buffs.Num());
+		Buffs.ForEachSlot([this, &RemovedBuffs](int32 Slot)
 		{
-			BuffCount.Buff->DoRevertEffects(this, BuffCount.Count);
+			RemovedBuffs.Add(Buffs.GetBuffCount(Slot));
+		});
+
+		{
+			FAbilityTagMutationScope TagScope{ this };
+
+			// Buffs are still applied while their effects revert
+			for (const FBuffCount& BuffCount : RemovedBuffs)
+			{
+				BuffCount.Buff->DoRevertEffects(this, GetBuffSpec(BuffCount.Buff), BuffCount.Count);
+			}
+			Buffs.Empty();
 		}
+		BuffLifetimes.ResetAll();
+		UpdateTickRegistration();
 
 		NotifyBuffsChanged(RemovedBuffs, EBuffOperation::Removed);
 		return RemovedBuffs.Num() > 0;
@@ -488,6 +927,8 @@ bool UAbilitiesComponent::ResetBuffs()
 
 bool UAbilitiesComponent::RemoveBuffs(const TSet<FBuffCount>& InBuffs)
 {
+	NotifyDeferredBuffs();
+
 	TSet<FBuffCount> RemovedBuffs{};
 	if (HasAuthority() && InternalRemoveBuffs(InBuffs, RemovedBuffs))
 	{
@@ -508,37 +949,98 @@ bool UAbilitiesComponent::RemoveAllBuffs(const TSet<UBuff*>& InBuffs)
 	return RemoveBuffs(InBuffCounts);
 }
 
-bool UAbilitiesComponent::RemoveBuffsByTag(FGameplayTag Tag, bool bExact)
+namespace
 {
-	if (!Tag.IsValid())
-	{
-		return false;
-	}
-
-	TSet<FBuffCount> BuffsToRemove;
-	if(bExact)
-	{
-		for(const auto& Buff : Buffs)
+	// Buffers reused by ApplyBuffsToMany and RemoveBuffsFromMany
+	struct FManyBuffsScratch
+	{
+		TSet<FBuffCount> ValidBuffs;
+		TSet<FBuffCount> ModifiedBuffs;
+		bool bInUse = false;
+	};
+
+	template<typename Func>
+	int32 ModifyBuffsOfMany(TArrayView<UAbilitiesComponent* const> Targets, const TSet<FBuffCount>& InBuffs, Func Modify)
+	{
+		// Nested calls (e.g. from buff effects) can't reuse the shared buffers
+		static FManyBuffsScratch SharedScratch;
+		FManyBuffsScratch LocalScratch;
+		FManyBuffsScratch& Scratch = SharedScratch.bInUse? LocalScratch : SharedScratch;
+		TGuardValue<bool> InUseGuard{ Scratch.bInUse, true };
+
+		// Validated once for all targets
+		Scratch.ValidBuffs.Reset();
+		for (const FBuffCount& BuffCount : InBuffs)
 		{
-			check(Buff.Buff);
-			if(Buff.Buff->GetTags().HasTagExact(Tag))
+			if (BuffCount.Buff && BuffCount.Count > 0)
 			{
-				BuffsToRemove.Add(Buff);
+				Scratch.ValidBuffs.Add(BuffCount);
 			}
 		}
-	}
-	else
-	{
-		for(const auto& Buff : Buffs)
+		if (Scratch.ValidBuffs.Num() <= 0)
+		{
+			return 0;
+		}
+
+		int32 NumModified = 0;
+		for (UAbilitiesComponent* Target : Targets)
 		{
-			check(Buff.Buff);
-			if(Buff.Buff->GetTags().HasTag(Tag))
+			if (IsValid(Target) && Target->HasAuthority() && Modify(*Target, Scratch.ValidBuffs, Scratch.ModifiedBuffs))
 			{
-				BuffsToRemove.Add(Buff);
+				++NumModified;
 			}
 		}
+		return NumModified;
 	}
-	return RemoveBuffs(BuffsToRemove);
+}
+
+int32 UAbilitiesComponent::ApplyBuffsToMany(TArrayView<UAbilitiesComponent* const> Targets, const TSet<FBuffCount>& InBuffs)
+{
+	return ModifyBuffsOfMany(Targets, InBuffs, [](UAbilitiesComponent& Target, const TSet<FBuffCount>& ValidBuffs, TSet<FBuffCount>& AppliedBuffs)
+	{
+		// Removals deferred before are notified first. Applies keep accumulating.
+		if (Target.DeferredRemovedBuffs.Num() > 0)
+		{
+			Target.NotifyDeferredBuffs();
+		}
+
+		if (Target.InternalApplyBuffs(ValidBuffs, AppliedBuffs))
+		{
+			Target.DeferBuffsChanged(AppliedBuffs, EBuffOperation::Added);
+			return true;
+		}
+		return false;
+	});
+}
+
+int32 UAbilitiesComponent::RemoveBuffsFromMany(TArrayView<UAbilitiesComponent* const> Targets, const TSet<FBuffCount>& InBuffs)
+{
+	return ModifyBuffsOfMany(Targets, InBuffs, [](UAbilitiesComponent& Target, const TSet<FBuffCount>& ValidBuffs, TSet<FBuffCount>& RemovedBuffs)
+	{
+		if (Target.DeferredAppliedBuffs.Num() > 0)
+		{
+			Target.NotifyDeferredBuffs();
+		}
+
+		if (Target.InternalRemoveBuffs(ValidBuffs, RemovedBuffs))
+		{
+			Target.DeferBuffsChanged(RemovedBuffs, EBuffOperation::Removed);
+			return true;
+		}
+		return false;
+	});
+}
+
+bool UAbilitiesComponent::RemoveBuffsByTag(FGameplayTag Tag, bool bExact)
+{
+	if (!Tag.IsValid())
+	{
+		return false;
+	}
+
+	TArray<FBuffCount> FoundBuffs;
+	Buffs.GetBuffsByTag(Tag, bExact, FoundBuffs);
+	return RemoveBuffs(TSet<FBuffCount>{ FoundBuffs });
 }
 
 bool UAbilitiesComponent::HasBuffs(const TSet<UBuff*>& InBuffs, EAllAny Mode) const
@@ -570,27 +1072,53 @@ bool UAbilitiesComponent::HasBuffs(const TSet<UBuff*>& InBuffs, EAllAny Mode) co
 
 void UAbilitiesComponent::GetBuffsOfClass(TSubclassOf<UBuff> Class, TSet<FBuffCount>& OutBuffs) const
 {
+	TArray<FBuffCount> BuffsOfClass;
+	GetBuffsOfClass(Class, BuffsOfClass);
 	OutBuffs.Reset();
-	if (!Class)
+	OutBuffs.Append(BuffsOfClass);
+}
+
+void UAbilitiesComponent::GetBuffsOfClass(TSubclassOf<UBuff> Class, TArray<FBuffCount>& OutBuffs) const
+{
+	OutBuffs.Reset();
+	if (Class)
 	{
-		return;
+		Buffs.GetBuffsOfClass(Class.Get(), OutBuffs);
 	}
-	if (const auto* Container = BuffsByClass.Find({ Class.Get() }))
+}
+
+void UAbilitiesComponent::GetBuffsByTag(FGameplayTag Tag, TArray<FBuffCount>& OutBuffs, bool bExact) const
+{
+	OutBuffs.Reset();
+	Buffs.GetBuffsByTag(Tag, bExact, OutBuffs);
+}
+
+int32 UAbilitiesComponent::CountBuffsByTag(FGameplayTag Tag, bool bExact) const
+{
+	return Buffs.CountBuffsByTag(Tag, bExact);
+}
+
+const TSet<FBuffCount>& UAbilitiesComponent::GetAllBuffs() const
+{
+	if (CachedAllBuffsVersion != Buffs.GetVersion())
 	{
-		OutBuffs.Reserve(Container->Buffs.Num());
-		for (auto* Buff : Container->Buffs)
+		CachedAllBuffsVersion = Buffs.GetVersion();
+		CachedAllBuffs.Reset();
+		Buffs.ForEachSlot([this](int32 Slot)
 		{
-			const FBuffCount* BuffCount = Buffs.Find(Buff);
-
-			if (ensureMsgf(BuffCount, TEXT("Container had a buff that is not present in the global list of buffs.")))
-			{
-				OutBuffs.Add(*BuffCount);
-			}
-		}
+			CachedAllBuffs.Add(Buffs.GetBuffCount(Slot));
+		});
 	}
+	return CachedAllBuffs;
+}
+
+void UAbilitiesComponent::GetAllBuffs(TArray<FBuffCount>& OutBuffs) const
+{
+	OutBuffs.Reset();
+	Buffs.GetAllBuffs(OutBuffs);
 }
 
-bool UAbilitiesComponent::InternalApplyBuffs(const TSet<FBuffCount>& InBuffs, TSet<FBuffCount>& BuffsToApply)
+bool UAbilitiesComponent::InternalApplyBuffs(const TSet<FBuffCount>& InBuffs, TSet<FBuffCount>& BuffsToApply, const FBuffSpec* Spec)
 {
 	BuffsToApply.Reset();
 	if (InBuffs.Num() <= 0)
@@ -599,26 +1127,65 @@ bool UAbilitiesComponent::InternalApplyBuffs(const TSet<FBuffCount>& InBuffs, TS
 	}
 	BuffsToApply.Reserve(InBuffs.Num());
 
+	// Notify all tag changes at once
+	FAbilityTagMutationScope TagScope{ this };
+
 	TSet<UBuff*> BuffsToRemove;
+	TSet<FBuffCount> BuffsToRefresh;
+	TArray<FBuffCount> BuffsOfClass;
+	// Weaker spec of an applied buff that keeps its highest magnitude
+	bool bKeepSpec = false;
+	// Latest buff to apply of each stacking group
+	TMap<FGameplayTag, UBuff*> PendingByGroup;
+	auto GetMagnitude = [this, Spec](const UBuff* Buff)
+	{
+		if (Spec && Spec->Buff == Buff)
+		{
+			return Spec->Magnitude;
+		}
+		const int32 Slot = Buffs.Find(Buff);
+		return Slot != INDEX_NONE? Buffs.GetSpec(Slot).Magnitude : 1.f;
+	};
+
 	for (const FBuffCount& BuffCount : InBuffs)
 	{
 		UBuff* Buff = BuffCount.Buff;
-		if (!Buff || (!Buff->IsStackable() && HasBuff(Buff)))
+		if (!Buff)
 		{
 			continue;
 		}
 
-		FBuffTypeContainer SearchContainer{ Buff->GetClass() };
-		auto* Container = BuffsByClass.Find(SearchContainer);
-		if (!Container)
+		const int32 AppliedSlot = Buffs.Find(Buff);
+		if (AppliedSlot != INDEX_NONE && Buff->GetStackingGroup().IsValid())
 		{
-			// Add new container
-			SearchContainer.Buffs.Add(Buff);
-			BuffsByClass.Add(MoveTemp(SearchContainer));
+			// Applying the buff of a group again follows its policy too
+			switch (Buff->GetStackingPolicy())
+			{
+			case EBuffStackingPolicy::RefreshDuration:
+				BuffsToRefresh.Add({ Buff, 0 });
+				break;
+			case EBuffStackingPolicy::KeepHighestMagnitude:
+				bKeepSpec |= Spec && Spec->Buff == Buff && Spec->Magnitude < Buffs.GetSpec(AppliedSlot).Magnitude;
+				break;
+			default:
+				break;
+			}
 		}
-		else
+
+		if (!Buff->IsStackable() && AppliedSlot != INDEX_NONE)
+		{
+			continue;
+		}
+
+		if (Buff->IsUnique())
 		{
-			if (Buff->IsUnique())
+			UClass* Class = Buff->GetClass();
+			const FBuffCount* PendingOfClass = Algo::FindByPredicate(BuffsToApply, [Class](const FBuffCount& Pending)
+			{
+				return Pending.Buff->GetClass() == Class;
+			});
+
+			if (Buffs.HasClass(Class) || PendingOfClass)
 			{
 				// Don't add this buff since theres already another one
 				// of the same type
@@ -628,62 +1195,131 @@ bool UAbilitiesComponent::InternalApplyBuffs(const TSet<FBuffCount>& InBuffs, TS
 				}
 
 				// Replace previous buffs
-				BuffsToRemove.Append(Container->Buffs);
-				Container->Buffs = { Buff };
+				BuffsOfClass.Reset();
+				Buffs.GetBuffsOfClass(Class, BuffsOfClass);
+				for (const FBuffCount& Previous : BuffsOfClass)
+				{
+					BuffsToRemove.Add(Previous.Buff);
+				}
+				if (PendingOfClass)
+				{
+					BuffsToApply.Remove(FBuffCount{ *PendingOfClass });
+				}
 			}
-			else
+		}
+
+		const FGameplayTag& Group = Buff->GetStackingGroup();
+		if (Group.IsValid())
+		{
+			UBuff* const* PendingOfGroup = PendingByGroup.Find(Group);
+			const int32 GroupSlot = Buffs.FindGroupSlot(Group);
+			UBuff* Current = PendingOfGroup? *PendingOfGroup : (GroupSlot != INDEX_NONE? Buffs.GetBuff(GroupSlot) : nullptr);
+			if (Current && Current != Buff)
 			{
-				Container->Buffs.Add(Buff);
+				const EBuffStackingPolicy Policy = Buff->GetStackingPolicy();
+				if (Policy == EBuffStackingPolicy::Reject ||
+					(Policy == EBuffStackingPolicy::KeepHighestMagnitude && GetMagnitude(Buff) <= GetMagnitude(Current)))
+				{
+					continue;
+				}
+
+				if (Policy == EBuffStackingPolicy::RefreshDuration)
+				{
+					// Pending buffs start their lifetime anyway
+					if (!PendingOfGroup)
+					{
+						BuffsToRefresh.Add({ Current, 0 });
+					}
+					continue;
+				}
+
+				// Replace buffs of the group
+				if (PendingOfGroup)
+				{
+					BuffsToApply.Remove(FBuffCount{ Current });
+				}
+				if (GroupSlot != INDEX_NONE)
+				{
+					BuffsToRemove.Add(Buffs.GetBuff(GroupSlot));
+				}
 			}
+			PendingByGroup.Add(Group, Buff);
 		}
 
 		BuffsToApply.Add(BuffCount);
 	}
 
-	// Remove conflicting Unique Buffs
+	// Remove conflicting Unique and grouped Buffs
 	RemoveAllBuffs(BuffsToRemove);
 
+	// Restart lifetimes without changing counts
+	BuffLifetimes.Refresh(BuffsToRefresh);
+	for (const FBuffCount& BuffCount : BuffsToRefresh)
+	{
+		switch (GetBuffReplicationMode(*BuffCount.Buff))
+		{
+		case EBuffReplicationMode::OwningClient:
+			OwnerReplicatedBuffs.Refresh(BuffCount.Buff);
+			break;
+		case EBuffReplicationMode::AllClients:
+			ReplicatedBuffs.Refresh(BuffCount.Buff);
+			break;
+		}
+	}
+
 	// Apply effects and count
 	const bool bHasAuthority = HasAuthority();
-	Buffs.Reserve(Buffs.Num() + BuffsToApply.Num());
-	if (HasAuthority())
+	for (const FBuffCount& InBuffCount : BuffsToApply)
 	{
-		for (const FBuffCount& InBuffCount : BuffsToApply)
-		{
-			UBuff* Buff = InBuffCount.Buff;
+		UBuff* Buff = InBuffCount.Buff;
+
+		const bool bNewSpec = Spec && Spec->Buff == Buff && !bKeepSpec;
 
-			if (FBuffCount* BuffCount = Buffs.Find(InBuffCount))
+		int32 Slot = Buffs.Find(Buff);
+		if (Slot != INDEX_NONE)
+		{
+			const int32 OldCount = Buffs.GetCount(Slot);
+			const int32 Count = OldCount + InBuffCount.Count;
+			if (bNewSpec)
 			{
-				Buff->DoRevertEffects(this, BuffCount->Count);
-				BuffCount->Count += InBuffCount.Count;
-				Buff->DoApplyEffects(this, BuffCount->Count);
+				// Latest spec replaces the previous one. Old effects revert before it is stored.
+				if (bHasAuthority)
+				{
+					Buff->DoRevertEffects(this, Buffs.GetSpec(Slot), OldCount);
+				}
+				Buffs.SetCount(Slot, Count);
+				Buffs.SetSpec(Slot, *Spec);
+				if (bHasAuthority)
+				{
+					Buff->DoApplyEffects(this, *Spec, Count);
+				}
+				continue;
 			}
-			else
+
+			Buffs.SetCount(Slot, Count);
+			if (bHasAuthority)
 			{
-				Buffs.Add(InBuffCount);
-				Buff->DoApplyEffects(this, InBuffCount.Count);
+				Buff->DoApplyStackDelta(this, Buffs.GetSpec(Slot), OldCount, Count);
 			}
 		}
-	}
-	else
-	{
-		for (const FBuffCount& InBuffCount : BuffsToApply)
+		else
 		{
-			if (FBuffCount* BuffCount = Buffs.Find(InBuffCount))
+			Slot = Buffs.Add(Buff, InBuffCount.Count);
+			if (bNewSpec)
 			{
-				BuffCount->Count += InBuffCount.Count;
+				Buffs.SetSpec(Slot, *Spec);
 			}
-			else
+			if (bHasAuthority)
 			{
-				Buffs.Add(InBuffCount);
+				Buff->DoApplyEffects(this, Buffs.GetSpec(Slot), InBuffCount.Count);
 			}
 		}
 	}
-	Buffs.Shrink();
 
 	BuffLifetimes.Start(BuffsToApply);
+	UpdateTickRegistration();
 
-	return BuffsToApply.Num() > 0;
+	return BuffsToApply.Num() > 0 || BuffsToRefresh.Num() > 0;
 }
 
 bool UAbilitiesComponent::InternalRemoveBuffs(const TSet<FBuffCount>& InBuffs, TSet<FBuffCount>& RemovedBuffs)
@@ -695,121 +1331,477 @@ bool UAbilitiesComponent::InternalRemoveBuffs(const TSet<FBuffCount>& InBuffs, T
 	}
 	RemovedBuffs.Reserve(InBuffs.Num());
 
+	// Notify all tag changes at once
+	FAbilityTagMutationScope TagScope{ this };
+
 	const bool bHasAuthority = HasAuthority();
-	for (FBuffCount InBuffCount : InBuffs)
+	for (const FBuffCount& InBuffCount : InBuffs)
 	{
 		UBuff* Buff = InBuffCount.Buff;
-		if (!Buff) { continue; }
-
-		FSetElementId Id = Buffs.FindId(InBuffCount);
-		if (!Id.IsValidId())
+		const int32 Slot = Buffs.Find(Buff);
+		if (Slot == INDEX_NONE)
 		{
 			continue; // This buff was not found
 		}
 
-		FBuffCount& BuffCount = Buffs[Id];
-		int32& Count = BuffCount.Count;
-
-		if (bHasAuthority)
-		{
-			Buff->DoRevertEffects(this, Count);
-		}
-
+		const int32 Count = Buffs.GetCount(Slot);
 		if (Count > InBuffCount.Count)
 		{
 			// Removed desired buffs
 			RemovedBuffs.Add(InBuffCount);
 
-			// Reapply with remaining count
-			Count -= InBuffCount.Count;
+			// Keep applied with remaining count
+			Buffs.SetCount(Slot, Count - InBuffCount.Count);
 
 			if (bHasAuthority)
 			{
-				Buff->DoApplyEffects(this, Count);
+				Buff->DoApplyStackDelta(this, Buffs.GetSpec(Slot), Count, Count - InBuffCount.Count);
 			}
 			continue;
 		}
 
-		// Removed count buffs, witch is less than desired
-		RemovedBuffs.Add(BuffCount);
-		Buffs.Remove(Id);
-
-		{ // Remove from ClassToBuff cache
-			FSetElementId ClassId = BuffsByClass.FindId({ Buff->GetClass() });
-
-			if (!ensureMsgf(ClassId.IsValidId(), TEXT("Buff was removed but didn't find a category")))
-			{
-				continue;
-			}
-
-			auto& ContainerBuffs = BuffsByClass[ClassId].Buffs;
-			if (ContainerBuffs.Remove(Buff) > 0)
-			{
-				// Remove container if empty
-				if (ContainerBuffs.Num() <= 0)
-				{
-					BuffsByClass.Remove(ClassId);
-				}
-			}
+		if (bHasAuthority)
+		{
+			Buff->DoRevertEffects(this, Buffs.GetSpec(Slot), Count);
 		}
+
+		// Removed count buffs, witch is less than desired
+		RemovedBuffs.Add({ Buff, Count });
+		Buffs.RemoveAt(Slot);
 	}
-	Buffs.Shrink();
 
 	BuffLifetimes.Reset(RemovedBuffs);
+	UpdateTickRegistration();
 	return RemovedBuffs.Num() > 0;
 }
 
 void UAbilitiesComponent::NotifyBuffsChanged(const TSet<FBuffCount>& ModifiedBuffs, EBuffOperation Change)
 {
+	if (ModifiedBuffs.Num() <= 0)
+	{
+		return; // Buffs may only have been refreshed
+	}
+
+	for (const FBuffCount& BuffCount : ModifiedBuffs)
+	{
+		ReplicateBuff(*BuffCount.Buff);
+	}
+
 	LocalOnBuffsChanged(ModifiedBuffs, Change);
+}
 
-	// Constexpr optimized away at compile-time
-	switch (BuffReplication)
+void UAbilitiesComponent::ReplicateBuff(const UBuff& Buff)
+{
+	switch (GetBuffReplicationMode(Buff))
 	{
 	case EBuffReplicationMode::OwningClient:
-		if (!IsLocallyOwned())
-		{
-			ClientOnBuffsChanged(ModifiedBuffs.Array(), Change);
-		}
+		OwnerReplicatedBuffs.SetCount(GetBuffSpec(&Buff), GetBuffCount(&Buff));
 		break;
 	case EBuffReplicationMode::AllClients:
-		MCOnBuffsChanged(ModifiedBuffs.Array(), Change);
+		ReplicatedBuffs.SetCount(GetBuffSpec(&Buff), GetBuffCount(&Buff));
 		break;
 	}
 }
 
-void UAbilitiesComponent::ClientOnBuffsChanged_Implementation(const TArray<FBuffCount>& ModifiedBuffs, EBuffOperation Change)
+void UAbilitiesComponent::SetPeriodicBuff(const UBuff& Buff, bool bApplied)
 {
-	if (!HasAuthority()) // Ignore server
+	UWorld* World = GetWorld();
+	if (auto* Subsystem = World? World->GetSubsystem<UAbilitiesWorldSubsystem>() : nullptr)
 	{
-		const TSet<FBuffCount> BuffsSet{ ModifiedBuffs };
-		LocalOnBuffsChanged(BuffsSet, Change);
+		if (bApplied)
+		{
+			Subsystem->AddPeriodicBuff(*this, Buff);
+		}
+		else
+		{
+			Subsystem->RemovePeriodicBuff(*this, Buff);
+		}
 	}
 }
 
-void UAbilitiesComponent::MCOnBuffsChanged_Implementation(const TArray<FBuffCount>& ModifiedBuffs, EBuffOperation Change)
+void UAbilitiesComponent::DeferBuffsChanged(const TSet<FBuffCount>& ModifiedBuffs, EBuffOperation Change)
 {
-	if (!HasAuthority()) // Ignore server
+	if (ModifiedBuffs.Num() <= 0)
 	{
-		const TSet<FBuffCount> BuffsSet{ ModifiedBuffs };
-		LocalOnBuffsChanged(BuffsSet, Change);
+		return;
 	}
+
+	TSet<FBuffCount>& DeferredBuffs = (Change == EBuffOperation::Added)? DeferredAppliedBuffs : DeferredRemovedBuffs;
+	for (const FBuffCount& BuffCount : ModifiedBuffs)
+	{
+		if (FBuffCount* Deferred = DeferredBuffs.Find(BuffCount))
+		{
+			Deferred->Count += BuffCount.Count;
+		}
+		else
+		{
+			DeferredBuffs.Add(BuffCount);
+		}
+	}
+
+	ScheduleBuffFlush();
 }
 
-void UAbilitiesComponent::LocalOnBuffsChanged(const TSet<FBuffCount>& ModifiedBuffs, EBuffOperation Change)
+void UAbilitiesComponent::ScheduleBuffFlush()
 {
-	if (!HasAuthority())
+	if (bBuffFlushPending)
 	{
-		TSet<FBuffCount> ResultBuffs{};
-		switch(Change)
+		return;
+	}
+
+	UWorld* World = GetWorld();
+	auto* Subsystem = World? World->GetSubsystem<UAbilitiesWorldSubsystem>() : nullptr;
+	if (Subsystem)
+	{
+		bBuffFlushPending = true;
+		Subsystem->AddPendingBuffFlush(*this);
+	}
+	else
+	{
+		FlushDeferredBuffs();
+	}
+}
+
+void UAbilitiesComponent::FlushDeferredBuffs()
+{
+	bBuffFlushPending = false;
+	NotifyDeferredBuffs();
+	FlushBuffEvents();
+}
+
+void UAbilitiesComponent::NotifyDeferredBuffs()
+{
+	if (DeferredAppliedBuffs.Num() <= 0 && DeferredRemovedBuffs.Num() <= 0)
+	{
+		return;
+	}
+
+	// Listeners can defer new changes
+	const TSet<FBuffCount> AppliedBuffs = MoveTemp(DeferredAppliedBuffs);
+	const TSet<FBuffCount> RemovedBuffs = MoveTemp(DeferredRemovedBuffs);
+	DeferredAppliedBuffs.Reset();
+	DeferredRemovedBuffs.Reset();
+
+	if (AppliedBuffs.Num() > 0)
+	{
+		NotifyBuffsChanged(AppliedBuffs, EBuffOperation::Added);
+	}
+	if (RemovedBuffs.Num() > 0)
+	{
+		NotifyBuffsChanged(RemovedBuffs, EBuffOperation::Removed);
+	}
+}
+
+void UAbilitiesComponent::FlushBuffEvents()
+{
+	if (CoalescedOldCounts.Num() <= 0 || bBroadcastingBuffEvents)
+	{
+		return;
+	}
+
+	// Arrays keep their memory between frames
+	TArray<FBuffCount>& Applied = CoalescedApplied;
+	TArray<FBuffCount>& Removed = CoalescedRemoved;
+	TArray<FBuffCount>& StackChanged = CoalescedStackChanged;
+	Applied.Reset();
+	Removed.Reset();
+	StackChanged.Reset();
+
+	TSet<FBuffCount> AppliedDeltas;
+	TSet<FBuffCount> RemovedDeltas;
+	const bool bBroadcastApplied = OnBuffsApplied.IsBound();
+	const bool bBroadcastRemoved = OnBuffsRemoved.IsBound();
+
+	for (const auto& It : CoalescedOldCounts)
+	{
+		UBuff* Buff = It.Key;
+		const int32 OldCount = It.Value;
+		const int32 NewCount = GetBuffCount(Buff);
+		if (OldCount == NewCount)
+		{
+			continue; // Changes cancelled each other
+		}
+
+		if (OldCount <= 0)
+		{
+			Applied.Add({ Buff, NewCount });
+		}
+		else if (NewCount <= 0)
+		{
+			Removed.Add({ Buff, OldCount });
+		}
+		else
+		{
+			StackChanged.Add({ Buff, NewCount });
+		}
+
+		if (NewCount > OldCount && bBroadcastApplied)
+		{
+			AppliedDeltas.Add({ Buff, NewCount - OldCount });
+		}
+		else if (NewCount < OldCount && bBroadcastRemoved)
+		{
+			RemovedDeltas.Add({ Buff, OldCount - NewCount });
+		}
+	}
+	CoalescedOldCounts.Reset();
+
+	{
+		// Changes done by listeners are coalesced into the next flush
+		TGuardValue<bool> BroadcastGuard{ bBroadcastingBuffEvents, true };
+		if (AppliedDeltas.Num() > 0)
+		{
+			OnBuffsApplied.Broadcast(AppliedDeltas);
+		}
+		if (RemovedDeltas.Num() > 0)
+		{
+			OnBuffsRemoved.Broadcast(RemovedDeltas);
+		}
+		if (Applied.Num() > 0 || Removed.Num() > 0 || StackChanged.Num() > 0)
+		{
+			OnBuffsChanged.Broadcast({ Applied, Removed, StackChanged });
+		}
+	}
+
+	if (CoalescedOldCounts.Num() > 0)
+	{
+		ScheduleBuffFlush();
+	}
+}
+
+void UAbilitiesComponent::SetCoalesceBuffEvents(bool bEnabled)
+{
+	if (bCoalesceBuffEvents != bEnabled)
+	{
+		bCoalesceBuffEvents = bEnabled;
+		if (!bEnabled)
+		{
+			FlushBuffEvents();
+		}
+	}
+}
+
+EBuffReplicationMode UAbilitiesComponent::GetBuffReplicationMode(const UBuff& Buff)
+{
+	switch (Buff.GetReplication())
+	{
+	case EBuffReplicationPolicy::OnlyServer:
+		return EBuffReplicationMode::OnlyServer;
+	case EBuffReplicationPolicy::OwningClient:
+		return EBuffReplicationMode::OwningClient;
+	case EBuffReplicationPolicy::AllClients:
+		return EBuffReplicationMode::AllClients;
+	default:
+		return BuffReplication;
+	}
+}
+
+void UAbilitiesComponent::OnReplicatedBuffChanged(const FBuffSpec& Spec, int32 Count)
+{
+	if (HasAuthority() || !Spec.Buff) // Ignore server
+	{
+		return;
+	}
+
+	// Predictions not acknowledged yet stay on top of the replicated count
+	int32 PredictedCount = 0;
+	for (const FPredictedBuff& Predicted : PredictedBuffs)
+	{
+		if (Predicted.Spec.Buff == Spec.Buff)
+		{
+			PredictedCount += Predicted.Count;
+		}
+	}
+
+	SetLocalBuffCount(Spec, Count + PredictedCount);
+}
+
+void UAbilitiesComponent::OnReplicatedBuffRefreshed(UBuff* Buff)
+{
+	if (!HasAuthority() && Buff && HasBuff(Buff))
+	{
+		BuffLifetimes.Refresh({ FBuffCount{ Buff, 0 } });
+	}
+}
+
+bool UAbilitiesComponent::ApplyPredictedBuff(const FBuffPredictionKey& Key, const FBuffSpec& Spec, int32 Count)
+{
+	if (HasAuthority())
+	{
+		return ApplyBuffSpec(Spec, Count);
+	}
+
+	UBuff* Buff = Spec.Buff;
+	if (!IsLocallyOwned() || !Key.IsValid() || !Buff || Count <= 0 ||
+		(!Buff->IsStackable() && HasBuff(Buff)))
+	{
+		return false;
+	}
+
+	// Buffs that don't reach this client would never be confirmed
+	if (GetBuffReplicationMode(*Buff) == EBuffReplicationMode::OnlyServer)
+	{
+		return false;
+	}
+
+	// Conflicts with unique and grouped buffs are resolved by server only
+	if (Buff->IsUnique() && Buffs.HasClass(Buff->GetClass()) && !HasBuff(Buff))
+	{
+		return false;
+	}
+	const FGameplayTag& Group = Buff->GetStackingGroup();
+	const int32 GroupSlot = Group.IsValid()? Buffs.FindGroupSlot(Group) : INDEX_NONE;
+	if (GroupSlot != INDEX_NONE && Buffs.GetBuff(GroupSlot) != Buff)
+	{
+		return false;
+	}
+
+	PredictedBuffs.Add({ Key, Spec, Count });
+	SetLocalBuffCount(Spec, GetBuffCount(Buff) + Count);
+	return true;
+}
+
+void UAbilitiesComponent::AcknowledgePredictions(const FBuffPredictionKey& Key)
+{
+	if (!HasAuthority() || !Key.IsValid())
+	{
+		return;
+	}
+
+	FBuffPredictionKey* Ack = PredictionAcks.FindByPredicate([&Key](const FBuffPredictionKey& Item)
+	{
+		return Item.Ability == Key.Ability;
+	});
+	if (!Ack)
+	{
+		PredictionAcks.Add(Key);
+	}
+	else if (Ack->RequestId < Key.RequestId)
+	{
+		Ack->RequestId = Key.RequestId;
+	}
+}
+
+void UAbilitiesComponent::ConfirmPredictedBuffs(const FBuffPredictionKey& Key)
+{
+	// Buffs server didn't apply are dropped the same way, so they never leak
+	RemovePredictedBuffs([&Key](const FPredictedBuff& Predicted)
+	{
+		return Key.Confirms(Predicted.Key);
+	});
+}
+
+void UAbilitiesComponent::RevertPredictedBuffs(const UAbilityBase* Ability, uint32 RequestId)
+{
+	RemovePredictedBuffs([Ability, RequestId](const FPredictedBuff& Predicted)
+	{
+		return Predicted.Key.Ability == Ability && (RequestId == 0 || Predicted.Key.RequestId == RequestId);
+	});
+}
+
+void UAbilitiesComponent::OnRep_PredictionAcks()
+{
+	// Buff counts received with the acknowledgment are already applied
+	for (const FBuffPredictionKey& Ack : PredictionAcks)
+	{
+		if (PredictedBuffs.Num() <= 0)
 		{
-		case EBuffOperation::Added:
-			InternalApplyBuffs(ModifiedBuffs, ResultBuffs);
-			break;
-		case EBuffOperation::Removed:
-			InternalRemoveBuffs(ModifiedBuffs, ResultBuffs);
 			break;
 		}
+		ConfirmPredictedBuffs(Ack);
+	}
+}
+
+void UAbilitiesComponent::RemovePredictedBuffs(TFunctionRef<bool(const FPredictedBuff&)> Predicate)
+{
+	// Local counts are the replicated ones plus pending predictions
+	for (int32 I = PredictedBuffs.Num() - 1; I >= 0; --I)
+	{
+		const FPredictedBuff Predicted = PredictedBuffs[I];
+		if (Predicted.Key.Ability == nullptr || Predicate(Predicted))
+		{
+			PredictedBuffs.RemoveAtSwap(I, 1, false);
+			SetLocalBuffCount(Predicted.Spec, GetBuffCount(Predicted.Spec.Buff) - Predicted.Count);
+		}
+	}
+}
+
+void UAbilitiesComponent::SetLocalBuffCount(const FBuffSpec& Spec, int32 Count)
+{
+	UBuff* Buff = Spec.Buff;
+	Count = FMath::Max(Count, 0);
+
+	int32 Slot = Buffs.Find(Buff);
+	const int32 OldCount = Slot != INDEX_NONE? Buffs.GetCount(Slot) : 0;
+	const bool bSpecChanged = Slot != INDEX_NONE && Count > 0 &&
+		(Buffs.GetSpec(Slot).Magnitude != Spec.Magnitude || Buffs.GetSpec(Slot).Level != Spec.Level);
+	if (Count == OldCount && !bSpecChanged)
+	{
+		return;
+	}
+
+	// Effects only run on server, but attributes are aggregated locally
+	if (Buff->GetModifiers().Num() > 0)
+	{
+		Attributes.SetModifiers(Buff, Buff->GetModifiers(), Count, Spec.Magnitude);
+	}
+
+	if (Count == OldCount)
+	{
+		Buffs.SetSpec(Slot, Spec);
+		return;
+	}
+
+	const TSet<FBuffCount> ModifiedBuffs{ FBuffCount{ Buff, FMath::Abs(Count - OldCount) } };
+	if (Count > OldCount)
+	{
+		if (Slot == INDEX_NONE)
+		{
+			Slot = Buffs.Add(Buff, Count);
+		}
+		else
+		{
+			Buffs.SetCount(Slot, Count);
+		}
+		Buffs.SetSpec(Slot, Spec);
+		BuffLifetimes.Start(ModifiedBuffs);
+		UpdateTickRegistration();
+		LocalOnBuffsChanged(ModifiedBuffs, EBuffOperation::Added);
+	}
+	else
+	{
+		if (Count <= 0)
+		{
+			Buffs.RemoveAt(Slot);
+		}
+		else
+		{
+			Buffs.SetCount(Slot, Count);
+			Buffs.SetSpec(Slot, Spec);
+		}
+		// Removed stacks stop counting their lifetime, same as on server
+		BuffLifetimes.Reset(ModifiedBuffs);
+		UpdateTickRegistration();
+		LocalOnBuffsChanged(ModifiedBuffs, EBuffOperation::Removed);
+	}
+}
+
+void UAbilitiesComponent::LocalOnBuffsChanged(const TSet<FBuffCount>& ModifiedBuffs, EBuffOperation Change)
+{
+	if (bCoalesceBuffEvents)
+	{
+		for (const FBuffCount& BuffCount : ModifiedBuffs)
+		{
+			if (!CoalescedOldCounts.Contains(BuffCount.Buff))
+			{
+				// Buffs are already modified. Recover the count before this change.
+				const int32 Count = GetBuffCount(BuffCount.Buff);
+				CoalescedOldCounts.Add(BuffCount.Buff,
+					(Change == EBuffOperation::Added)? Count - BuffCount.Count : Count + BuffCount.Count);
+			}
+		}
+		ScheduleBuffFlush();
+		return;
 	}
 
 	switch(Change)
@@ -823,6 +1815,275 @@ void UAbilitiesComponent::LocalOnBuffsChanged(const TSet<FBuffCount>& ModifiedBu
 	}
 }
 
+void UAbilitiesComponent::CaptureSnapshot(TArray<uint8>& OutData) const
+{
+	FAbilitiesSnapshot Snapshot;
+
+	Snapshot.Abilities.Reserve(EquippedAbilities.Num());
+	for (const auto& Class : EquippedAbilities)
+	{
+		if (Class)
+		{
+			Snapshot.Abilities.Add(FSoftClassPath{ Class.Get() });
+		}
+	}
+
+	Snapshot.Buffs.Reserve(Buffs.Num());
+	Buffs.ForEachSlot([this, &Snapshot](int32 Slot)
+	{
+		const FBuffSpec Spec = Buffs.GetSpec(Slot);
+		FAbilitiesSnapshot::FBuffEntry& Entry = Snapshot.Buffs.AddDefaulted_GetRef();
+		Entry.Buff = FSoftObjectPath{ Spec.Buff };
+		Entry.Count = Buffs.GetCount(Slot);
+		Entry.Magnitude = Spec.Magnitude;
+		Entry.Level = Spec.Level;
+		BuffLifetimes.GetRemainingTimes(Spec.Buff, Entry.Lifetimes);
+	});
+
+	Snapshot.Cooldowns.Reserve(Cooldowns.GetAbilities().Num());
+	for (UClass* Ability : Cooldowns.GetAbilities())
+	{
+		Snapshot.Cooldowns.Add({ FSoftClassPath{ Ability }, Cooldowns.GetRemaining(Ability) });
+	}
+
+	// Tags held by applied buffs are granted again when they are restored, so their grants are not counted
+	TMap<FGameplayTag, int32> BuffGrants;
+	GetBuffTagGrants(BuffGrants);
+	const TArray<FGameplayTag>& GrantedTags = Tags.GetGameplayTagArray();
+	Snapshot.Tags.Reserve(GrantedTags.Num());
+	for (const FGameplayTag& Tag : GrantedTags)
+	{
+		const int32 Count = TagCounts.GetCount(Tag) - BuffGrants.FindRef(Tag);
+		if (Count != 0)
+		{
+			Snapshot.Tags.Add({ Tag, Count });
+		}
+	}
+
+	Snapshot.Write(OutData);
+}
+
+bool UAbilitiesComponent::RestoreSnapshot(const TArray<uint8>& Data)
+{
+	FAbilitiesSnapshot Snapshot;
+	if (!HasAuthority() || !Snapshot.Read(Data))
+	{
+		return false;
+	}
+	NotifyDeferredBuffs();
+
+	// Notify all tag changes at once
+	FAbilityTagMutationScope TagScope{ this };
+
+	// Abilities. Classes that are not loaded are skipped.
+	TSet<TSubclassOf<UAbility>> Abilities;
+	for (const FSoftClassPath& Path : Snapshot.Abilities)
+	{
+		UClass* Class = Path.ResolveClass();
+		if (Class && Class->IsChildOf<UAbility>())
+		{
+			Abilities.Add(Class);
+		}
+	}
+	TArray<TSubclassOf<UAbility>> AbilitiesToUnequip;
+	for (const auto& Class : EquippedAbilities)
+	{
+		if (!Abilities.Contains(Class))
+		{
+			AbilitiesToUnequip.Add(Class);
+		}
+	}
+	InternalUnequipAbilities(AbilitiesToUnequip);
+	EquipAbilities(Abilities);
+
+	// Buffs. Only differences with the snapshot are applied or removed, so that unchanged buffs keep their effects.
+	TMap<UBuff*, const FAbilitiesSnapshot::FBuffEntry*> Entries;
+	Entries.Reserve(Snapshot.Buffs.Num());
+	for (const FAbilitiesSnapshot::FBuffEntry& Entry : Snapshot.Buffs)
+	{
+		// Buffs that are not loaded are skipped
+		if (UBuff* Buff = Cast<UBuff>(Entry.Buff.ResolveObject()))
+		{
+			if (Entry.Count > 0)
+			{
+				Entries.Add(Buff, &Entry);
+			}
+		}
+	}
+
+	TMap<UBuff*, int32> OldCounts;
+	TSet<FBuffCount> BuffsToRemove;
+	OldCounts.Reserve(Buffs.Num());
+	Buffs.ForEachSlot([this, &Entries, &OldCounts, &BuffsToRemove](int32 Slot)
+	{
+		UBuff* Buff = Buffs.GetBuff(Slot);
+		const int32 Count = Buffs.GetCount(Slot);
+		OldCounts.Add(Buff, Count);
+
+		const auto* Entry = Entries.FindRef(Buff);
+		const int32 Excess = Count - (Entry? Entry->Count : 0);
+		if (Excess > 0)
+		{
+			BuffsToRemove.Add({ Buff, Excess });
+		}
+	});
+
+	TSet<FBuffCount> ModifiedBuffs;
+	InternalRemoveBuffs(BuffsToRemove, ModifiedBuffs);
+
+	TArray<UBuff*> ChangedSpecs;
+	for (const auto& It : Entries)
+	{
+		UBuff* Buff = It.Key;
+		const FAbilitiesSnapshot::FBuffEntry& Entry = *It.Value;
+		const FBuffSpec Spec{ Buff, Entry.Magnitude, nullptr, Entry.Level };
+
+		const int32 Slot = Buffs.Find(Buff);
+		if (Slot == INDEX_NONE)
+		{
+			InternalApplyBuffs({ FBuffCount{ Buff, Entry.Count } }, ModifiedBuffs, &Spec);
+		}
+		else
+		{
+			const FBuffSpec OldSpec = Buffs.GetSpec(Slot);
+			const int32 Count = Buffs.GetCount(Slot);
+			if (OldSpec.Magnitude != Spec.Magnitude || OldSpec.Level != Spec.Level)
+			{
+				// Effects of the previous spec revert before it is replaced
+				Buff->DoRevertEffects(this, OldSpec, Count);
+				Buffs.SetSpec(Slot, Spec);
+				Buff->DoApplyEffects(this, Spec, Count);
+				ChangedSpecs.Add(Buff);
+			}
+			if (Entry.Count > Count)
+			{
+				InternalApplyBuffs({ FBuffCount{ Buff, Entry.Count - Count } }, ModifiedBuffs);
+			}
+		}
+		BuffLifetimes.SetRemainingTimes(Buff, Entry.Lifetimes);
+	}
+
+	// Only net count changes are notified
+	TSet<FBuffCount> AppliedBuffs;
+	TSet<FBuffCount> RemovedBuffs;
+	for (const auto& It : Entries)
+	{
+		const int32 Delta = GetBuffCount(It.Key) - OldCounts.FindRef(It.Key);
+		if (Delta > 0)
+		{
+			AppliedBuffs.Add({ It.Key, Delta });
+		}
+	}
+	for (const auto& OldCount : OldCounts)
+	{
+		const int32 Delta = OldCount.Value - GetBuffCount(OldCount.Key);
+		if (Delta > 0)
+		{
+			RemovedBuffs.Add({ OldCount.Key, Delta });
+		}
+	}
+	for (UBuff* Buff : ChangedSpecs)
+	{
+		// Specs may have changed without notifying a count change
+		if (!AppliedBuffs.Contains(Buff))
+		{
+			ReplicateBuff(*Buff);
+		}
+	}
+	if (AppliedBuffs.Num() > 0)
+	{
+		DeferBuffsChanged(AppliedBuffs, EBuffOperation::Added);
+	}
+	if (RemovedBuffs.Num() > 0)
+	{
+		DeferBuffsChanged(RemovedBuffs, EBuffOperation::Removed);
+	}
+
+	// Cooldowns of equipped abilities are multicast and notified as if started or reset by them
+	TMap<UClass*, float> RestoredCooldowns;
+	for (const FAbilitiesSnapshot::FCooldownEntry& Entry : Snapshot.Cooldowns)
+	{
+		UClass* Class = Entry.Ability.ResolveClass();
+		if (Class && Class->IsChildOf<UAbility>())
+		{
+			RestoredCooldowns.Add(Class, FMath::Max(Entry.Remaining, 0.f));
+		}
+	}
+	const TArray<UClass*> CoolingDown = Cooldowns.GetAbilities();
+	for (UClass* Class : CoolingDown)
+	{
+		if (RestoredCooldowns.Contains(Class))
+		{
+			continue;
+		}
+		if (UAbility* Ability = GetEquippedAbility(Class))
+		{
+			Ability->ResetCooldown();
+		}
+		else
+		{
+			Cooldowns.Reset(Class);
+		}
+	}
+	for (const auto& Cooldown : RestoredCooldowns)
+	{
+		if (UAbility* Ability = GetEquippedAbility(Cooldown.Key))
+		{
+			Ability->RestoreCooldown(Cooldown.Value);
+		}
+		else
+		{
+			Cooldowns.Start(Cooldown.Key, Cooldown.Value);
+		}
+	}
+	InvalidateAvailability();
+
+	// Tags held by buffs are already restored with them, so buffs that were not loaded don't leave their tags.
+	// Other grants are reconciled with the snapshot in one change.
+	TMap<FGameplayTag, int32> TargetCounts;
+	if (!Snapshot.bTagCountsIncludeBuffs)
+	{
+		GetBuffTagGrants(TargetCounts);
+	}
+	for (const FAbilitiesSnapshot::FTagEntry& Entry : Snapshot.Tags)
+	{
+		if (Entry.Tag.IsValid())
+		{
+			TargetCounts.FindOrAdd(Entry.Tag) += Entry.Count;
+		}
+	}
+	for (const FGameplayTag& Tag : Tags.GetGameplayTagArray())
+	{
+		TargetCounts.FindOrAdd(Tag, 0);
+	}
+
+	TArray<FGameplayTag, TInlineAllocator<8>> Grants;
+	TArray<FGameplayTag, TInlineAllocator<8>> Revokes;
+	for (const auto& Target : TargetCounts)
+	{
+		const int32 Delta = Target.Value - TagCounts.GetCount(Target.Key);
+		for (int32 I = 0; I < FMath::Abs(Delta); ++I)
+		{
+			(Delta > 0? Grants : Revokes).Add(Target.Key);
+		}
+	}
+	ApplyTagChanges(Grants, Revokes);
+
+	UpdateTickRegistration();
+	return true;
+}
+
+void UAbilitiesComponent::GetBuffTagGrants(TMap<FGameplayTag, int32>& OutGrants) const
+{
+	Buffs.ForEachSlot([this, &OutGrants](int32 Slot)
+	{
+		for (const FGameplayTag& Tag : Buffs.GetBuff(Slot)->GetTagsToApply())
+		{
+			++OutGrants.FindOrAdd(Tag);
+		}
+	});
+}
+
 bool UAbilitiesComponent::IsLocallyOwned() const
 {
 	const AActor* Owner = GetOwner();
@@ -1,10 +1,9 @@
-
 // Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
 
 #include "AbilitiesCooldownCounter.h"
 
+#include <Algo/BinarySearch.h>
 #include <Engine/World.h>
-#include <TimerManager.h>
 
 #include "Ability.h"
 #include "AbilitiesComponent.h"
@@ -17,28 +16,34 @@ void FAbilitiesCooldownCounter::Start(UClass* Ability, float Duration)
 		return;
 	}
 
-	FTimerHandle& Handle = Handles.FindOrAdd(Ability);
-	GetTimerManager()->SetTimer(Handle, [this, Ability]()
+	const UWorld* World = GetWorld();
+	if (!World)
 	{
-		Handles.Remove(Ability);
+		return;
+	}
 
-		if (auto* Owner = GetOwner<UAbilitiesComponent>())
-		{
-			// If the ability is equipped, notify it
-			if (UAbility* Instance = Owner->GetEquippedAbility(Ability))
-			{
-				Instance->NotifyCooldownReady(ECooldownReadyReason::Finished);
-			}
-		}
-	}, Duration, false);
+	// Restarting a cooldown replaces the previous one
+	const int32 PreviousIndex = Abilities.IndexOfByKey(Ability);
+	if (PreviousIndex != INDEX_NONE)
+	{
+		RemoveAt(PreviousIndex);
+	}
+
+	const float EndTime = World->GetTimeSeconds() + Duration;
+	const int32 Index = Algo::UpperBound(EndTimes, EndTime);
+	EndTimes.Insert(EndTime, Index);
+	Abilities.Insert(Ability, Index);
+
+	UpdateOwnerTick();
 }
 
 bool FAbilitiesCooldownCounter::Reset(UClass* Ability)
 {
-	FTimerHandle Handle;
-	if (Handles.RemoveAndCopyValue(Ability, Handle))
+	const int32 Index = Abilities.IndexOfByKey(Ability);
+	if (Index != INDEX_NONE)
 	{
-		GetTimerManager()->ClearTimer(Handle);
+		RemoveAt(Index);
+		UpdateOwnerTick();
 		return true;
 	}
 	return false;
@@ -46,29 +51,76 @@ bool FAbilitiesCooldownCounter::Reset(UClass* Ability)
 
 void FAbilitiesCooldownCounter::ResetAll()
 {
-	FTimerManager* TimerManager = GetTimerManager();
-	for (TPair<UClass*, FTimerHandle>& HandleItem : Handles)
+	Abilities.Empty();
+	EndTimes.Empty();
+	UpdateOwnerTick();
+
+	if (auto* Owner = GetOwner<UAbilitiesComponent>())
 	{
-		TimerManager->ClearTimer(HandleItem.Value);
+		Owner->InvalidateAvailability();
 	}
-	Handles.Empty();
 }
 
 float FAbilitiesCooldownCounter::GetRemaining(UClass* Ability) const
 {
-	if (const FTimerHandle* Handle = Handles.Find(Ability))
+	const int32 Index = Abilities.IndexOfByKey(Ability);
+	const UWorld* World = GetWorld();
+	if (Index != INDEX_NONE && World)
 	{
-		FTimerManager* Manager = GetTimerManager();
-		return Manager->GetTimerRemaining(*Handle);
+		return FMath::Max(EndTimes[Index] - World->GetTimeSeconds(), 0.f);
 	}
 	return 0.f;
 }
 
-FTimerManager* FAbilitiesCooldownCounter::GetTimerManager() const
+void FAbilitiesCooldownCounter::Tick()
+{
+	const UWorld* World = GetWorld();
+	if (Abilities.Num() <= 0 || !World)
+	{
+		return;
+	}
+
+	const float GameTime = World->GetTimeSeconds();
+	int32 NumFinished = 0;
+	while (NumFinished < EndTimes.Num() && EndTimes[NumFinished] <= GameTime)
+	{
+		++NumFinished;
+	}
+
+	if (NumFinished <= 0)
+	{
+		return;
+	}
+
+	// Notifications can start new cooldowns, so remove finished ones first
+	TArray<UClass*, TInlineAllocator<8>> Finished{ Abilities.GetData(), NumFinished };
+	Abilities.RemoveAt(0, NumFinished, false);
+	EndTimes.RemoveAt(0, NumFinished, false);
+
+	if (auto* Owner = GetOwner<UAbilitiesComponent>())
+	{
+		for (UClass* Ability : Finished)
+		{
+			// If the ability is equipped, notify it
+			if (UAbility* Instance = Owner->GetEquippedAbility(Ability))
+			{
+				Instance->NotifyCooldownReady(ECooldownReadyReason::Finished);
+			}
+		}
+	}
+	UpdateOwnerTick();
+}
+
+void FAbilitiesCooldownCounter::RemoveAt(int32 Index)
+{
+	Abilities.RemoveAt(Index, 1, false);
+	EndTimes.RemoveAt(Index, 1, false);
+}
+
+void FAbilitiesCooldownCounter::UpdateOwnerTick() const
 {
-	if (auto* World = GetWorld())
+	if (auto* Owner = GetOwner<UAbilitiesComponent>())
 	{
-		return &World->GetTimerManager();
+		Owner->UpdateTickRegistration();
 	}
-	return nullptr;
 }
@@ -0,0 +1,198 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "AbilitiesSnapshot.h"
+
+#include <Serialization/MemoryReader.h>
+#include <Serialization/MemoryWriter.h>
+
+
+namespace AbilitiesSnapshot
+{
+	static constexpr uint32 Magic = 0x53534241; // "ABSS"
+
+	// Strings of a snapshot. Older versions write them inline.
+	struct FStringTable
+	{
+		int32 Version = 0;
+		TArray<FString> Strings;
+		TMap<FString, int32> Indices;
+
+		void Serialize(FArchive& Ar, FString& String)
+		{
+			if (Version < FAbilitiesSnapshot::StringTable)
+			{
+				Ar << String;
+				return;
+			}
+
+			int32 Index = Ar.IsSaving()? Indices.FindChecked(String) : INDEX_NONE;
+			Ar << Index;
+			if (Ar.IsLoading())
+			{
+				if (!Strings.IsValidIndex(Index))
+				{
+					Ar.SetError();
+					return;
+				}
+				String = Strings[Index];
+			}
+		}
+	};
+
+	// Paths are stored as strings to stay independent of name tables
+	template<typename PathType>
+	void SerializePath(FArchive& Ar, FStringTable& Table, PathType& Path)
+	{
+		FString PathString = Ar.IsSaving()? Path.ToString() : FString{};
+		Table.Serialize(Ar, PathString);
+		if (Ar.IsLoading() && !Ar.IsError())
+		{
+			Path.SetPath(PathString);
+		}
+	}
+
+	void SerializeTag(FArchive& Ar, FStringTable& Table, FGameplayTag& Tag)
+	{
+		FString TagName = Ar.IsSaving()? Tag.ToString() : FString{};
+		Table.Serialize(Ar, TagName);
+		if (Ar.IsLoading() && !Ar.IsError())
+		{
+			// Tags removed since the snapshot was taken are skipped on restore
+			Tag = FGameplayTag::RequestGameplayTag(*TagName, false);
+		}
+	}
+
+	template<typename Type>
+	void SerializeNum(FArchive& Ar, TArray<Type>& Array)
+	{
+		int32 Num = Array.Num();
+		Ar << Num;
+		if (Ar.IsLoading())
+		{
+			// Don't trust sizes of corrupted data
+			if (Num < 0 || Num > Ar.TotalSize())
+			{
+				Ar.SetError();
+				return;
+			}
+			Array.SetNum(Num);
+		}
+	}
+}
+
+
+void FAbilitiesSnapshot::Write(TArray<uint8>& OutData)
+{
+	OutData.Reset();
+	FMemoryWriter Writer{ OutData };
+
+	uint32 Magic = AbilitiesSnapshot::Magic;
+	int32 Version = EVersion::Latest;
+	Writer << Magic;
+	Writer << Version;
+	Serialize(Writer, Version);
+}
+
+bool FAbilitiesSnapshot::Read(const TArray<uint8>& Data)
+{
+	FMemoryReader Reader{ Data };
+	// Corrupted string lengths can't allocate more than the data
+	Reader.ArMaxSerializeSize = Data.Num();
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	Reader << Magic;
+	Reader << Version;
+	if (Reader.IsError() || Magic != AbilitiesSnapshot::Magic || Version <= 0 || Version > EVersion::Latest)
+	{
+		return false;
+	}
+
+	Serialize(Reader, Version);
+	bTagCountsIncludeBuffs = Version < EVersion::TagsWithoutBuffs;
+	return !Reader.IsError();
+}
+
+void FAbilitiesSnapshot::Serialize(FArchive& Ar, int32 Version)
+{
+	using namespace AbilitiesSnapshot;
+
+	FStringTable Table;
+	Table.Version = Version;
+	if (Version >= StringTable)
+	{
+		if (Ar.IsSaving())
+		{
+			GatherStrings(Table.Strings, Table.Indices);
+		}
+		SerializeNum(Ar, Table.Strings);
+		for (int32 I = 0; I < Table.Strings.Num() && !Ar.IsError(); ++I)
+		{
+			Ar << Table.Strings[I];
+		}
+	}
+
+	SerializeNum(Ar, Abilities);
+	for (int32 I = 0; I < Abilities.Num() && !Ar.IsError(); ++I)
+	{
+		SerializePath(Ar, Table, Abilities[I]);
+	}
+
+	SerializeNum(Ar, Buffs);
+	for (int32 I = 0; I < Buffs.Num() && !Ar.IsError(); ++I)
+	{
+		FBuffEntry& Entry = Buffs[I];
+		SerializePath(Ar, Table, Entry.Buff);
+		Ar << Entry.Count;
+		Ar << Entry.Magnitude;
+		Ar << Entry.Level;
+		SerializeNum(Ar, Entry.Lifetimes);
+		for (int32 J = 0; J < Entry.Lifetimes.Num() && !Ar.IsError(); ++J)
+		{
+			Ar << Entry.Lifetimes[J];
+		}
+	}
+
+	SerializeNum(Ar, Cooldowns);
+	for (int32 I = 0; I < Cooldowns.Num() && !Ar.IsError(); ++I)
+	{
+		SerializePath(Ar, Table, Cooldowns[I].Ability);
+		Ar << Cooldowns[I].Remaining;
+	}
+
+	SerializeNum(Ar, Tags);
+	for (int32 I = 0; I < Tags.Num() && !Ar.IsError(); ++I)
+	{
+		SerializeTag(Ar, Table, Tags[I].Tag);
+		Ar << Tags[I].Count;
+	}
+}
+
+void FAbilitiesSnapshot::GatherStrings(TArray<FString>& OutStrings, TMap<FString, int32>& OutIndices) const
+{
+	auto Add = [&OutStrings, &OutIndices](FString&& String)
+	{
+		if (!OutIndices.Contains(String))
+		{
+			OutIndices.Add(String, OutStrings.Num());
+			OutStrings.Add(MoveTemp(String));
+		}
+	};
+
+	for (const FSoftClassPath& Ability : Abilities)
+	{
+		Add(Ability.ToString());
+	}
+	for (const FBuffEntry& Entry : Buffs)
+	{
+		Add(Entry.Buff.ToString());
+	}
+	for (const FCooldownEntry& Entry : Cooldowns)
+	{
+		Add(Entry.Ability.ToString());
+	}
+	for (const FTagEntry& Entry : Tags)
+	{
+		Add(Entry.Tag.ToString());
+	}
+}
@@ -0,0 +1,297 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "AbilitiesWorldSubsystem.h"
+#include <Engine/World.h>
+
+#include "AbilitiesComponent.h"
+
+
+bool UAbilitiesWorldSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void UAbilitiesWorldSubsystem::Deinitialize()
+{
+	for (auto* Component : Components)
+	{
+		if (Component)
+		{
+			Component->SubsystemTickIndex = INDEX_NONE;
+		}
+	}
+	Components.Empty();
+	FlushBuffs();
+	PeriodBuckets.Empty();
+	NumPeriodicBuffs = 0;
+	Super::Deinitialize();
+}
+
+void UAbilitiesWorldSubsystem::Register(UAbilitiesComponent& Component)
+{
+	if (Component.SubsystemTickIndex == INDEX_NONE)
+	{
+		Component.SubsystemTickIndex = Components.Add(&Component);
+	}
+}
+
+void UAbilitiesWorldSubsystem::Unregister(UAbilitiesComponent& Component)
+{
+	const int32 Index = Component.SubsystemTickIndex;
+	if (!Components.IsValidIndex(Index) || !ensure(Components[Index] == &Component))
+	{
+		return;
+	}
+	Component.SubsystemTickIndex = INDEX_NONE;
+
+	if (bIsTicking)
+	{
+		// Can't move components while iterating. Compacted after the tick.
+		Components[Index] = nullptr;
+		bHasPendingRemovals = true;
+		return;
+	}
+
+	Components.RemoveAtSwap(Index, 1, false);
+	if (Components.IsValidIndex(Index))
+	{
+		Components[Index]->SubsystemTickIndex = Index;
+	}
+}
+
+void UAbilitiesWorldSubsystem::AddPendingBuffFlush(UAbilitiesComponent& Component)
+{
+	PendingBuffFlushes.Add(&Component);
+}
+
+void UAbilitiesWorldSubsystem::AddPeriodicBuff(UAbilitiesComponent& Component, const UBuff& Buff)
+{
+	const float Period = GetBuffPeriod(Buff);
+	const UWorld* World = GetWorld();
+	if (Period <= 0.f || !World)
+	{
+		return;
+	}
+
+	FBuffPeriodBucket* Bucket = PeriodBuckets.FindByPredicate([Period](const FBuffPeriodBucket& Item)
+	{
+		return Item.Period == Period;
+	});
+	if (!Bucket)
+	{
+		Bucket = &PeriodBuckets.AddDefaulted_GetRef();
+		Bucket->Period = Period;
+	}
+
+	int32& Index = Bucket->Indices.FindOrAdd({ &Component, &Buff }, INDEX_NONE);
+	if (Index != INDEX_NONE)
+	{
+		return;
+	}
+
+	const float NextTime = World->GetTimeSeconds() + Period;
+	// Idle buckets have no earlier entry
+	Bucket->NextTime = (Bucket->Indices.Num() == 1)? NextTime : FMath::Min(Bucket->NextTime, NextTime);
+
+	Index = Bucket->Components.Add(&Component);
+	Bucket->Buffs.Add(&Buff);
+	Bucket->NextTimes.Add(NextTime);
+	++NumPeriodicBuffs;
+}
+
+void UAbilitiesWorldSubsystem::RemovePeriodicBuff(UAbilitiesComponent& Component, const UBuff& Buff)
+{
+	const float Period = GetBuffPeriod(Buff);
+	FBuffPeriodBucket* Bucket = PeriodBuckets.FindByPredicate([Period](const FBuffPeriodBucket& Item)
+	{
+		return Item.Period == Period;
+	});
+
+	int32 Index = INDEX_NONE;
+	if (!Bucket || !Bucket->Indices.RemoveAndCopyValue({ &Component, &Buff }, Index))
+	{
+		return;
+	}
+	--NumPeriodicBuffs;
+
+	// Entries can't move while their bucket fires. Compacted after.
+	Bucket->Components[Index] = nullptr;
+	Bucket->Buffs[Index] = nullptr;
+	Bucket->bHasPendingRemovals = true;
+}
+
+void UAbilitiesWorldSubsystem::Tick(float DeltaTime)
+{
+	FlushBuffs();
+	TickPeriodicBuffs();
+
+	{
+		TGuardValue<bool> TickingGuard{ bIsTicking, true };
+
+		// Components registered during the tick are ticked on the same frame
+		for (int32 I = 0; I < Components.Num(); ++I)
+		{
+			UAbilitiesComponent* Component = Components[I];
+			if (Component && !Component->IsPendingKill())
+			{
+				Component->BatchedTick(DeltaTime);
+			}
+		}
+	}
+
+	if (bHasPendingRemovals)
+	{
+		CompactComponents();
+	}
+}
+
+ETickableTickType UAbilitiesWorldSubsystem::GetTickableTickType() const
+{
+	// The CDO also constructs a tickable object. It should never tick.
+	return HasAnyFlags(RF_ClassDefaultObject)? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UAbilitiesWorldSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAbilitiesWorldSubsystem, STATGROUP_Tickables);
+}
+
+void UAbilitiesWorldSubsystem::FlushBuffs()
+{
+	// Flushes can defer more notifications for next frame
+	const TArray<TWeakObjectPtr<UAbilitiesComponent>> Flushes = MoveTemp(PendingBuffFlushes);
+	PendingBuffFlushes.Reset();
+
+	for (const auto& Component : Flushes)
+	{
+		if (Component.IsValid())
+		{
+			Component->FlushDeferredBuffs();
+		}
+	}
+}
+
+void UAbilitiesWorldSubsystem::TickPeriodicBuffs()
+{
+	const UWorld* World = GetWorld();
+	if (NumPeriodicBuffs <= 0 || !World)
+	{
+		return;
+	}
+
+	const float GameTime = World->GetTimeSeconds();
+	for (int32 I = 0; I < PeriodBuckets.Num(); ++I)
+	{
+		if (PeriodBuckets[I].Indices.Num() > 0 && PeriodBuckets[I].NextTime <= GameTime)
+		{
+			FireBucket(I, GameTime);
+		}
+
+		if (PeriodBuckets[I].bHasPendingRemovals)
+		{
+			CompactBucket(PeriodBuckets[I]);
+		}
+	}
+}
+
+void UAbilitiesWorldSubsystem::FireBucket(int32 BucketIndex, float GameTime)
+{
+	// Buffs applied while firing wait for their first period.
+	// Bucket is not referenced across period callbacks, since those may add new buckets.
+	const int32 NumEntries = PeriodBuckets[BucketIndex].Buffs.Num();
+	for (int32 I = 0; I < NumEntries; ++I)
+	{
+		// Fires once per elapsed period, so long frames don't lose ticks
+		for (int32 NumFired = 0; PeriodBuckets[BucketIndex].NextTimes[I] <= GameTime; ++NumFired)
+		{
+			FBuffPeriodBucket& Current = PeriodBuckets[BucketIndex];
+			UAbilitiesComponent* Component = Current.Components[I].Get();
+			const UBuff* Buff = Current.Buffs[I].Get();
+			if (!Component || !Buff || Component->IsPendingKill())
+			{
+				// Owner or buff destroyed without removing the entry
+				Current.bHasPendingRemovals = true;
+				break;
+			}
+
+			if (NumFired >= MaxPeriodsPerTick)
+			{
+				// Skip missed periods, keeping the phase of the buff
+				const float Missed = FMath::FloorToFloat((GameTime - Current.NextTimes[I]) / Current.Period) + 1.f;
+				Current.NextTimes[I] += Missed * Current.Period;
+				break;
+			}
+
+			Current.NextTimes[I] += Current.Period;
+			Buff->DoPeriod(Component, Component->GetBuffCount(Buff));
+		}
+	}
+
+	FBuffPeriodBucket& Bucket = PeriodBuckets[BucketIndex];
+	Bucket.NextTime = TNumericLimits<float>::Max();
+	for (int32 I = 0; I < Bucket.NextTimes.Num(); ++I)
+	{
+		if (!Bucket.Buffs[I].IsExplicitlyNull())
+		{
+			Bucket.NextTime = FMath::Min(Bucket.NextTime, Bucket.NextTimes[I]);
+		}
+	}
+}
+
+void UAbilitiesWorldSubsystem::CompactBucket(FBuffPeriodBucket& Bucket)
+{
+	Bucket.bHasPendingRemovals = false;
+
+	// New index of each entry, by its old index
+	TArray<int32, TInlineAllocator<64>> NewIndices;
+	NewIndices.SetNumUninitialized(Bucket.Buffs.Num());
+
+	int32 NewNum = 0;
+	for (int32 I = 0; I < Bucket.Buffs.Num(); ++I)
+	{
+		if (Bucket.Buffs[I].IsValid() && Bucket.Components[I].IsValid())
+		{
+			NewIndices[I] = NewNum;
+			Bucket.Components[NewNum] = Bucket.Components[I];
+			Bucket.Buffs[NewNum] = Bucket.Buffs[I];
+			Bucket.NextTimes[NewNum] = Bucket.NextTimes[I];
+			++NewNum;
+		}
+		else
+		{
+			NewIndices[I] = INDEX_NONE;
+		}
+	}
+	Bucket.Components.SetNum(NewNum, false);
+	Bucket.Buffs.SetNum(NewNum, false);
+	Bucket.NextTimes.SetNum(NewNum, false);
+
+	for (auto It = Bucket.Indices.CreateIterator(); It; ++It)
+	{
+		It.Value() = NewIndices[It.Value()];
+		if (It.Value() == INDEX_NONE)
+		{
+			// Destroyed entries were never removed
+			It.RemoveCurrent();
+			--NumPeriodicBuffs;
+		}
+	}
+}
+
+float UAbilitiesWorldSubsystem::GetBuffPeriod(const UBuff& Buff)
+{
+	const float Period = Buff.GetPeriod();
+	return (Period > 0.f)? FMath::Max(Period, float(MinBuffPeriod)) : 0.f;
+}
+
+void UAbilitiesWorldSubsystem::CompactComponents()
+{
+	bHasPendingRemovals = false;
+	Components.RemoveAllSwap([](const UAbilitiesComponent* Component) { return Component == nullptr; }, false);
+
+	for (int32 I = 0; I < Components.Num(); ++I)
+	{
+		Components[I]->SubsystemTickIndex = I;
+	}
+}
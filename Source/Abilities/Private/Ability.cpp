@@ -12,6 +12,7 @@
 #include "AbilitiesComponent.h"
 #include "AbilitiesCooldownCounter.h"
 #include "AbilitiesModule.h"
+#include "Misc/Helpers.h"
 #include "Misc/Macros.h"
 
 
@@ -37,9 +38,7 @@ bool UAbility::CheckTransition(FAbilityStateTransition Transition, const FStruct
 	{
 		auto* const Comp = GetAbilitiesComponent();
 		// Check if we have required and denied tags on the component
-		if (!Comp || IsCoolingDown() ||
-			!Comp->GetTags().HasAllExact(RequiredTags) ||
-			 Comp->GetTags().HasAnyExact(RequiredToNotHaveTags))
+		if (!Comp || IsCoolingDown() || !GetTagRequirements().Check(Comp->GetTagMask()))
 		{
 			return false;
 		}
@@ -48,9 +47,11 @@ bool UAbility::CheckTransition(FAbilityStateTransition Transition, const FStruct
 	switch(Transition.Destination)
 	{
 	case EAbilityState::Cast:
-		return EventCanCast(Container);
+		return IsBlueprintEventImplemented(EAbilityBlueprintEvent::CanCast)?
+			EventCanCast(Container) : EventCanCast_Implementation(Container);
 	case EAbilityState::Activation:
-		return EventCanActivate(Container);
+		return IsBlueprintEventImplemented(EAbilityBlueprintEvent::CanActivate)?
+			EventCanActivate(Container) : EventCanActivate_Implementation(Container);
 	}
 	return true;
 }
@@ -68,32 +69,56 @@ void UAbility::OnStateChanged(FAbilityStateTransition Transition, const FStructC
 		return;
 	}
 
+	Comp->InvalidateAvailability(*this);
+
+	// Tags changed by both states are notified once
+	FAbilityTagMutationScope TagScope{ Comp };
+
 	// Stop old state
 	switch(Transition.Origin)
 	{
 	case EAbilityState::Cast:
+		Comp->RemoveInterruptListener(*this);
+
 		// Apply pre-cast effects
 		Comp->AddTags(CastFinishAddTags);
 		Comp->RemoveTags(CastFinishRemoveTags);
 
-		EventCastFinish();
+		if (IsBlueprintEventImplemented(EAbilityBlueprintEvent::CastFinish))
+		{
+			EventCastFinish();
+		}
+		else
+		{
+			EventCastFinish_Implementation();
+		}
 
 		if (TickMode == EAbilityTickMode::DuringCastOnly)
 		{
-			Comp->TickingAbilities.Remove(this);
+			Comp->RemoveTickingAbility(this);
 		}
 		break;
 
 	case EAbilityState::Activation:
+		Comp->RemoveInterruptListener(*this);
+
 		// Apply post-deactivation effects
 		Comp->AddTags(DeactivationAddTags);
 		Comp->RemoveTags(DeactivationRemoveTags);
 
-		EventDeactivate();
+		if (IsBlueprintEventImplemented(EAbilityBlueprintEvent::Deactivate))
+		{
+			EventDeactivate();
+		}
+		else
+		{
+			EventDeactivate_Implementation();
+		}
+
 		if (TickMode == EAbilityTickMode::DuringActivationOnly ||
 			TickMode == EAbilityTickMode::DuringCastAndActivation)
 		{
-			Comp->TickingAbilities.Remove(this);
+			Comp->RemoveTickingAbility(this);
 		}
 
 		if(bPredictionFailed)
@@ -115,7 +140,7 @@ void UAbility::OnStateChanged(FAbilityStateTransition Transition, const FStructC
 	case EAbilityState::BeforeBeginPlay:
 		if (TickMode == EAbilityTickMode::Always)
 		{
-			Comp->TickingAbilities.Add(this);
+			Comp->AddTickingAbility(this);
 		}
 	}
 
@@ -134,12 +159,24 @@ void UAbility::OnStateChanged(FAbilityStateTransition Transition, const FStructC
 		Comp->AddTags(CastStartAddTags);
 		Comp->RemoveTags(CastStartRemoveTags);
 
-		EventCast(Container);
+		if (IsBlueprintEventImplemented(EAbilityBlueprintEvent::Cast))
+		{
+			EventCast(Container);
+		}
+		else
+		{
+			EventCast_Implementation(Container);
+		}
+
+		if (bInterruptionCancelsCasting && GetState() == EAbilityState::Cast)
+		{
+			Comp->AddInterruptListener(*this);
+		}
 
 		if (TickMode == EAbilityTickMode::DuringCastOnly ||
 			TickMode == EAbilityTickMode::DuringCastAndActivation)
 		{
-			Comp->TickingAbilities.Add(this);
+			Comp->AddTickingAbility(this);
 		}
 		break;
 
@@ -153,17 +190,30 @@ void UAbility::OnStateChanged(FAbilityStateTransition Transition, const FStructC
 		Comp->AddTags(ActivationAddTags);
 		Comp->RemoveTags(ActivationRemoveTags);
 
-		EventActivate(Container);
+		if (IsBlueprintEventImplemented(EAbilityBlueprintEvent::Activate))
+		{
+			EventActivate(Container);
+		}
+		else
+		{
+			EventActivate_Implementation(Container);
+		}
+
+		if (bInterruptionCancelsActivation && GetState() == EAbilityState::Activation)
+		{
+			Comp->AddInterruptListener(*this);
+		}
+
 		if (TickMode == EAbilityTickMode::DuringActivationOnly)
 		{
-			Comp->TickingAbilities.Add(this);
+			Comp->AddTickingAbility(this);
 		}
 		break;
 
 	case EAbilityState::AfterEndPlay:
 		if (TickMode == EAbilityTickMode::Always)
 		{
-			Comp->TickingAbilities.Remove(this);
+			Comp->RemoveTickingAbility(this);
 		}
 	}
 }
@@ -192,7 +242,30 @@ void UAbility::MCResetCooldown_Implementation()
 	LocalResetCooldown();
 }
 
-void UAbility::LocalStartCooldown()
+void UAbility::MCRestoreCooldown_Implementation(float Remaining)
+{
+	auto* const Comp = GetAbilitiesComponent();
+	if (!HasCooldown() || !Comp)
+	{
+		return;
+	}
+
+	// A running cooldown is replaced without being notified as ready
+	const bool bWasCoolingDown = IsCoolingDown();
+	Comp->GetCooldowns().Start(GetClass(), FMath::Max(Remaining, 0.f));
+	Comp->InvalidateAvailability(*this);
+
+	if (!bWasCoolingDown)
+	{
+		OnCooldownStarted();
+		if (IsBlueprintEventImplemented(EAbilityBlueprintEvent::CooldownStarted))
+		{
+			EventOnCooldownStarted();
+		}
+	}
+}
+
+void UAbility::LocalStartCooldown(float Duration)
 {
 	if (!HasCooldown() || IsCoolingDown())
 	{
@@ -201,10 +274,14 @@ void UAbility::LocalStartCooldown()
 
 	if(auto* const Comp = GetAbilitiesComponent())
 	{
-		Comp->GetCooldowns().Start(GetClass(), CooldownDuration);
+		Comp->GetCooldowns().Start(GetClass(), Duration);
+		Comp->InvalidateAvailability(*this);
 
 		OnCooldownStarted();
-		EventOnCooldownStarted();
+		if (IsBlueprintEventImplemented(EAbilityBlueprintEvent::CooldownStarted))
+		{
+			EventOnCooldownStarted();
+		}
 	}
 }
 
@@ -221,8 +298,16 @@ void UAbility::LocalResetCooldown()
 
 void UAbility::NotifyCooldownReady(ECooldownReadyReason Reason)
 {
+	if (auto* const Comp = GetAbilitiesComponent())
+	{
+		Comp->InvalidateAvailability(*this);
+	}
+
 	OnCooldownReady(Reason);
-	EventOnCooldownReady(Reason);
+	if (IsBlueprintEventImplemented(EAbilityBlueprintEvent::CooldownReady))
+	{
+		EventOnCooldownReady(Reason);
+	}
 
 	if (Reason == ECooldownReadyReason::Finished &&
 		bInputWaitForCooldown && IsPressed())
@@ -248,21 +333,10 @@ void UAbility::Cancel(bool bApplyCooldown)
 
 void UAbility::OnTagsChanged(const FGameplayTagContainer& Tags)
 {
-	EventOnTagsChanged(Tags);
-
-	if (InterruptWithTags.Num() <= 0)
-	{
-		return;
-	}
-
-	// Interrupt ability by tag
-	if ((bInterruptionCancelsActivation && IsActivated()) ||
-	   ( bInterruptionCancelsCasting && IsCasting()))
+	// Interruptions are dispatched by the component. See UAbilitiesComponent::AddInterruptListener
+	if (IsBlueprintEventImplemented(EAbilityBlueprintEvent::TagsChanged))
 	{
-		if (Tags.HasAnyExact(InterruptWithTags))
-		{
-			Cancel(true);
-		}
+		EventOnTagsChanged(Tags);
 	}
 }
 
@@ -399,6 +473,32 @@ void UAbility::EventDeactivate_Implementation()
 	OnDeactivation();
 }
 
+EAbilityBlueprintEvent UAbility::FindBlueprintEvents() const
+{
+	static const TPair<FName, EAbilityBlueprintEvent> AbilityEvents[] = {
+		{ GET_FUNCTION_NAME_CHECKED(UAbility, EventCanCast),           EAbilityBlueprintEvent::CanCast },
+		{ GET_FUNCTION_NAME_CHECKED(UAbility, EventCast),              EAbilityBlueprintEvent::Cast },
+		{ GET_FUNCTION_NAME_CHECKED(UAbility, EventCastFinish),        EAbilityBlueprintEvent::CastFinish },
+		{ GET_FUNCTION_NAME_CHECKED(UAbility, EventCanActivate),       EAbilityBlueprintEvent::CanActivate },
+		{ GET_FUNCTION_NAME_CHECKED(UAbility, EventActivate),          EAbilityBlueprintEvent::Activate },
+		{ GET_FUNCTION_NAME_CHECKED(UAbility, EventDeactivate),        EAbilityBlueprintEvent::Deactivate },
+		{ GET_FUNCTION_NAME_CHECKED(UAbility, EventOnCooldownStarted), EAbilityBlueprintEvent::CooldownStarted },
+		{ GET_FUNCTION_NAME_CHECKED(UAbility, EventOnCooldownReady),   EAbilityBlueprintEvent::CooldownReady },
+		{ GET_FUNCTION_NAME_CHECKED(UAbility, EventOnTagsChanged),     EAbilityBlueprintEvent::TagsChanged }
+	};
+
+	const UClass* Class = GetClass();
+	EAbilityBlueprintEvent Events = Super::FindBlueprintEvents();
+	for (const auto& Event : AbilityEvents)
+	{
+		if (IsEventImplementedInBlueprint(Class, Event.Key))
+		{
+			Events |= Event.Value;
+		}
+	}
+	return Events;
+}
+
 UWorld* UAbility::GetWorld() const
 {
 	// If we are a CDO, we must return nullptr to fool UObject::ImplementsGetWorld.
@@ -442,6 +542,25 @@ void UAbility::PreDestroyFromReplication()
 	Super::PreDestroyFromReplication();
 }
 
+const FAbilityTagRequirements& UAbility::GetTagRequirements() const
+{
+	auto* Default = GetClass()->GetDefaultObject<UAbility>();
+	if (!Default->TagRequirements.bCompiled)
+	{
+		Default->TagRequirements.Compile(Default->RequiredTags, Default->RequiredToNotHaveTags);
+	}
+	return Default->TagRequirements;
+}
+
+void UAbility::PostLoad()
+{
+	Super::PostLoad();
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		TagRequirements.Compile(RequiredTags, RequiredToNotHaveTags);
+	}
+}
+
 #if WITH_EDITOR
 bool UAbility::CanEditChange(const UProperty* InProperty) const
 {
@@ -454,4 +573,11 @@ bool UAbility::CanEditChange(const UProperty* InProperty) const
 	}
 	return bCanEdit;
 }
+
+void UAbility::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	// Recompiled on next use
+	TagRequirements.bCompiled = false;
+}
 #endif //WITH_EDITOR
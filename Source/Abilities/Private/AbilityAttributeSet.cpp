@@ -0,0 +1,245 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "AbilityAttributeSet.h"
+
+
+int32 FAbilityAttributeSet::FindOrAddIndex(const FGameplayTag& Attribute)
+{
+	if (const int32* Index = Indices.Find(Attribute))
+	{
+		return *Index;
+	}
+
+	const int32 Index = Attributes.Add(Attribute);
+	Indices.Add(Attribute, Index);
+	BaseValues.Add(0.f);
+	Values.Add(0.f);
+	Dirty.Add(false);
+	Additives.Add(0.f);
+	Multipliers.Add(1.f);
+	Overrides.Add(0.f);
+	Overridden.Add(0);
+	return Index;
+}
+
+void FAbilityAttributeSet::SetBaseValue(const FGameplayTag& Attribute, float Value)
+{
+	if (!Attribute.IsValid())
+	{
+		return;
+	}
+
+	const int32 Index = FindOrAddIndex(Attribute);
+	if (BaseValues[Index] != Value)
+	{
+		BaseValues[Index] = Value;
+		MarkDirty(Index);
+	}
+}
+
+float FAbilityAttributeSet::GetBaseValue(const FGameplayTag& Attribute) const
+{
+	const int32 Index = FindIndex(Attribute);
+	return Index != INDEX_NONE? BaseValues[Index] : 0.f;
+}
+
+float FAbilityAttributeSet::GetValue(const FGameplayTag& Attribute) const
+{
+	const int32 Index = FindIndex(Attribute);
+	if (Index == INDEX_NONE)
+	{
+		return 0.f;
+	}
+
+	if (bAnyDirty)
+	{
+		Update();
+	}
+	return Values[Index];
+}
+
+void FAbilityAttributeSet::SetModifiers(const UBuff* Source, TArrayView<const FAttributeModifier> Modifiers, int32 Count, float Scale)
+{
+	// Modifiers of the buff, in the order they were applied
+	TArray<int32, TInlineAllocator<8>> OldModifiers;
+	for (int32 I = 0; I < ModifierSources.Num(); ++I)
+	{
+		if (ModifierSources[I] == Source)
+		{
+			OldModifiers.Add(I);
+		}
+	}
+
+	if (Count > 0 && UpdateModifiers(OldModifiers, Modifiers, Count, Scale))
+	{
+		return;
+	}
+
+	// Modifiers changed. Removing them keeps application order so that the last override wins.
+	for (int32 I = OldModifiers.Num() - 1; I >= 0; --I)
+	{
+		const int32 Modifier = OldModifiers[I];
+		MarkDirty(ModifierAttributes[Modifier]);
+		ModifierSources.RemoveAt(Modifier, 1, false);
+		ModifierAttributes.RemoveAt(Modifier, 1, false);
+		ModifierOps.RemoveAt(Modifier, 1, false);
+		ModifierMagnitudes.RemoveAt(Modifier, 1, false);
+	}
+
+	if (Count <= 0)
+	{
+		return;
+	}
+
+	for (const FAttributeModifier& Modifier : Modifiers)
+	{
+		if (!Modifier.Attribute.IsValid())
+		{
+			continue;
+		}
+
+		const int32 Index = FindOrAddIndex(Modifier.Attribute);
+		ModifierSources.Add(Source);
+		ModifierAttributes.Add(Index);
+		ModifierOps.Add(Modifier.Operation);
+		ModifierMagnitudes.Add(GetMagnitude(Modifier, Count, Scale));
+		MarkDirty(Index);
+	}
+}
+
+bool FAbilityAttributeSet::UpdateModifiers(TArrayView<const int32> OldModifiers, TArrayView<const FAttributeModifier> Modifiers, int32 Count, float Scale)
+{
+	// Only stacks or scale changed if every modifier matches the one applied before
+	int32 Old = 0;
+	for (const FAttributeModifier& Modifier : Modifiers)
+	{
+		if (!Modifier.Attribute.IsValid())
+		{
+			continue;
+		}
+
+		if (!OldModifiers.IsValidIndex(Old) ||
+			ModifierAttributes[OldModifiers[Old]] != FindIndex(Modifier.Attribute) ||
+			ModifierOps[OldModifiers[Old]] != Modifier.Operation)
+		{
+			return false;
+		}
+		++Old;
+	}
+	if (Old != OldModifiers.Num() || Old == 0)
+	{
+		return false;
+	}
+
+	Old = 0;
+	for (const FAttributeModifier& Modifier : Modifiers)
+	{
+		if (!Modifier.Attribute.IsValid())
+		{
+			continue;
+		}
+
+		const int32 I = OldModifiers[Old++];
+		const float Magnitude = GetMagnitude(Modifier, Count, Scale);
+		if (ModifierMagnitudes[I] != Magnitude)
+		{
+			ModifierMagnitudes[I] = Magnitude;
+			MarkDirty(ModifierAttributes[I]);
+		}
+	}
+	return true;
+}
+
+float FAbilityAttributeSet::GetMagnitude(const FAttributeModifier& Modifier, int32 Count, float Scale)
+{
+	switch (Modifier.Operation)
+	{
+	case EAttributeModifierOp::Additive:
+		return Modifier.Magnitude * Scale * Count;
+	case EAttributeModifierOp::Multiplicative:
+		return FMath::Pow(Modifier.Magnitude * Scale, float(Count));
+	default:
+		return Modifier.Magnitude;
+	}
+}
+
+void FAbilityAttributeSet::Empty()
+{
+	Attributes.Empty();
+	BaseValues.Empty();
+	Values.Empty();
+	Dirty.Empty();
+	bAnyDirty = false;
+	Indices.Empty();
+
+	ModifierSources.Empty();
+	ModifierAttributes.Empty();
+	ModifierOps.Empty();
+	ModifierMagnitudes.Empty();
+
+	Additives.Empty();
+	Multipliers.Empty();
+	Overrides.Empty();
+	Overridden.Empty();
+}
+
+SIZE_T FAbilityAttributeSet::GetAllocatedSize() const
+{
+	return Attributes.GetAllocatedSize() + BaseValues.GetAllocatedSize() + Values.GetAllocatedSize() +
+		Dirty.GetAllocatedSize() + Indices.GetAllocatedSize() +
+		ModifierSources.GetAllocatedSize() + ModifierAttributes.GetAllocatedSize() +
+		ModifierOps.GetAllocatedSize() + ModifierMagnitudes.GetAllocatedSize() +
+		Additives.GetAllocatedSize() + Multipliers.GetAllocatedSize() +
+		Overrides.GetAllocatedSize() + Overridden.GetAllocatedSize();
+}
+
+void FAbilityAttributeSet::Update() const
+{
+	const int32 NumAttributes = Attributes.Num();
+
+	// Accumulators are flat arrays so that every pass is a tight loop over contiguous memory
+	for (TConstSetBitIterator<> It(Dirty); It; ++It)
+	{
+		const int32 Index = It.GetIndex();
+		Additives[Index] = 0.f;
+		Multipliers[Index] = 1.f;
+		Overridden[Index] = 0;
+	}
+
+	// Only modifiers of dirty attributes are accumulated
+	const int32 NumModifiers = ModifierAttributes.Num();
+	for (int32 I = 0; I < NumModifiers; ++I)
+	{
+		const int32 Index = ModifierAttributes[I];
+		if (!Dirty[Index])
+		{
+			continue;
+		}
+
+		const float Magnitude = ModifierMagnitudes[I];
+		switch (ModifierOps[I])
+		{
+		case EAttributeModifierOp::Additive:
+			Additives[Index] += Magnitude;
+			break;
+		case EAttributeModifierOp::Multiplicative:
+			Multipliers[Index] *= Magnitude;
+			break;
+		case EAttributeModifierOp::Override:
+			Overrides[Index] = Magnitude;
+			Overridden[Index] = 1;
+			break;
+		}
+	}
+
+	for (TConstSetBitIterator<> It(Dirty); It; ++It)
+	{
+		const int32 Index = It.GetIndex();
+		Values[Index] = Overridden[Index]
+			? Overrides[Index]
+			: (BaseValues[Index] + Additives[Index]) * Multipliers[Index];
+	}
+
+	Dirty.Init(false, NumAttributes);
+	bAnyDirty = false;
+}
@@ -3,6 +3,7 @@
 #include "AbilityBase.h"
 #include <Net/UnrealNetwork.h>
 
+#include "Misc/Helpers.h"
 #include "Misc/Macros.h"
 #include "AbilitiesComponent.h"
 
@@ -33,6 +34,12 @@ void UAbilityBase::PreDestroyFromReplication()
 		DoEndPlay();
 	}
 
+	if (Owner)
+	{
+		// Server won't confirm predictions of a removed ability
+		Owner->RevertPredictedBuffs(this);
+	}
+
 	Super::PreDestroyFromReplication();
 }
 
@@ -46,6 +53,33 @@ void UAbilityBase::EventEndPlay_Implementation()
 	EndPlay();
 }
 
+bool UAbilityBase::IsBlueprintEventImplemented(EAbilityBlueprintEvent Event) const
+{
+	// Blueprint recompilation creates a new class and CDO, so this never goes stale
+	auto* Default = GetClass()->GetDefaultObject<UAbilityBase>();
+	if (!Default->bBlueprintEventsCached)
+	{
+		Default->BlueprintEvents = Default->FindBlueprintEvents();
+		Default->bBlueprintEventsCached = true;
+	}
+	return EnumHasAnyFlags(Default->BlueprintEvents, Event);
+}
+
+EAbilityBlueprintEvent UAbilityBase::FindBlueprintEvents() const
+{
+	const UClass* Class = GetClass();
+	EAbilityBlueprintEvent Events = EAbilityBlueprintEvent::None;
+	if (IsEventImplementedInBlueprint(Class, GET_FUNCTION_NAME_CHECKED(UAbilityBase, EventTick)))
+	{
+		Events |= EAbilityBlueprintEvent::Tick;
+	}
+	if (IsEventImplementedInBlueprint(Class, GET_FUNCTION_NAME_CHECKED(UAbilityBase, EventPreStateChange)))
+	{
+		Events |= EAbilityBlueprintEvent::PreStateChange;
+	}
+	return Events;
+}
+
 bool UAbilityBase::SetState(EAbilityState NewState, FStructContainer Container, EAbilityTransitionFlag Flags)
 {
 	const bool bHasAuthority = HasAuthority();
@@ -75,11 +109,20 @@ bool UAbilityBase::SetState(EAbilityState NewState, FStructContainer Container,
 		}
 		else if (bIsLocallyOwned)
 		{
-			OnStateChanged(Transition, CurrContainer);
+			const uint32 RequestId = GetNewRequestId();
+			{
+				TGuardValue<uint32> PredictionScope{ PredictionRequestId, RequestId };
+				OnStateChanged(Transition, CurrContainer);
+			}
 			// Notify server if state is still the new one
 			if (GetState() == Transition.Destination)
 			{
-				ServerSetState(Transition, CurrContainer, GetNewRequestId());
+				ServerSetState(Transition, CurrContainer, RequestId);
+			}
+			else if (Owner)
+			{
+				// Never requested, so nothing will confirm its buffs
+				Owner->RevertPredictedBuffs(this, RequestId);
 			}
 		}
 
@@ -106,6 +149,7 @@ void UAbilityBase::ServerSetState_Implementation(FAbilityStateTransition Transit
 	{
 		SetCurrentStateId(RequestedStateId);
 
+		TGuardValue<uint32> PredictionScope{ PredictionRequestId, RequestedStateId };
 		OnStateChanged(Transition, CurrContainer);
 		// Notify clients if state is still the new one
 		if (GetState() == Transition.Destination)
@@ -120,10 +164,22 @@ void UAbilityBase::ServerSetState_Implementation(FAbilityStateTransition Transit
 		ClientRejectState(RejectedTransition, RequestedStateId);
 	}
 	PopContainer();
+
+	if (Owner)
+	{
+		// Predicted buffs of this request are now included in replicated counts, if server applied them
+		Owner->AcknowledgePredictions({ this, RequestedStateId });
+	}
 }
 
 void UAbilityBase::ClientRejectState_Implementation(FAbilityStateTransition Transition, uint32 RequestedStateId)
 {
+	// Buffs of the rejected request were never applied on server
+	if (Owner)
+	{
+		Owner->RevertPredictedBuffs(this, RequestedStateId);
+	}
+
 	if (CurrentStateId > RequestedStateId)
 	{
 		// Another state change arrived before. This one is discarded
@@ -156,13 +212,23 @@ void UAbilityBase::MCSetState_Implementation(FAbilityStateTransition Transition,
 	}
 }
 
+bool UAbilityBase::ApplyPredictedBuff(const FBuffSpec& Spec, int32 Count)
+{
+	if (!Owner)
+	{
+		return false;
+	}
+
+	if (PredictionRequestId == 0)
+	{
+		return HasAuthority() && Owner->ApplyBuffSpec(Spec, Count);
+	}
+	return Owner->ApplyPredictedBuff({ this, PredictionRequestId }, Spec, Count);
+}
+
 bool UAbilityBase::TrySetLocalState(FAbilityStateTransition Transition, const FStructContainer& Container)
 {
-	if (!HasBegunPlay() ||
-		State == Transition.Destination ||
-		Transition.Origin == Transition.Destination ||
-		ForbiddenStates.Contains(Transition.Destination) ||
-		!CheckTransition(Transition, Container))
+	if (!CanTransition(Transition, Container))
 	{
 		return false;
 	}
@@ -171,6 +237,15 @@ bool UAbilityBase::TrySetLocalState(FAbilityStateTransition Transition, const FS
 	return true;
 }
 
+bool UAbilityBase::CanTransition(FAbilityStateTransition Transition, const FStructContainer& Container)
+{
+	return HasBegunPlay() &&
+		State != Transition.Destination &&
+		Transition.Origin != Transition.Destination &&
+		!ForbiddenStates.Contains(Transition.Destination) &&
+		CheckTransition(Transition, Container);
+}
+
 void UAbilityBase::DoBeginPlay(UAbilitiesComponent* InOwner)
 {
 	Owner = InOwner;
@@ -0,0 +1,70 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "AbilityTagCounter.h"
+
+
+bool FAbilityTagCounter::Grant(const FGameplayTag& Tag)
+{
+	const int32 Index = FAbilityTagIndex::Get().FindOrAddIndex(Tag);
+	if (Index >= Counts.Num())
+	{
+		Counts.SetNumZeroed(Index + 1);
+	}
+
+	int16& Count = Counts[Index];
+	if (!ensureMsgf(Count < MAX_int16, TEXT("Tag '%s' was granted too many times"), *Tag.ToString()))
+	{
+		return false;
+	}
+
+	if (++Count == 1)
+	{
+		Mask.Set(Index);
+		return true;
+	}
+	return false;
+}
+
+bool FAbilityTagCounter::Revoke(const FGameplayTag& Tag)
+{
+	const int32 Index = FAbilityTagIndex::Get().FindIndex(Tag);
+	if (!Counts.IsValidIndex(Index) || Counts[Index] <= 0)
+	{
+		return false;
+	}
+
+	if (--Counts[Index] == 0)
+	{
+		Mask.Clear(Index);
+		return true;
+	}
+	return false;
+}
+
+int32 FAbilityTagCounter::GetCount(const FGameplayTag& Tag) const
+{
+	const int32 Index = FAbilityTagIndex::Get().FindIndex(Tag);
+	return Counts.IsValidIndex(Index)? Counts[Index] : 0;
+}
+
+void FAbilityTagCounter::Reset(const FGameplayTagContainer& ExplicitTags)
+{
+	// Keep the memory to avoid reallocating it
+	FMemory::Memzero(Counts.GetData(), Counts.Num() * Counts.GetTypeSize());
+	Mask.Reset();
+	for (const FGameplayTag& Tag : ExplicitTags)
+	{
+		Grant(Tag);
+	}
+}
+
+void FAbilityTagCounter::GrantMissing(const FGameplayTagContainer& ExplicitTags)
+{
+	for (const FGameplayTag& Tag : ExplicitTags)
+	{
+		if (GetCount(Tag) <= 0)
+		{
+			Grant(Tag);
+		}
+	}
+}
@@ -0,0 +1,36 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "AbilityTagMask.h"
+
+
+FAbilityTagIndex& FAbilityTagIndex::Get()
+{
+	static FAbilityTagIndex Instance;
+	return Instance;
+}
+
+int32 FAbilityTagIndex::FindOrAddIndex(const FGameplayTag& Tag)
+{
+	check(IsInGameThread());
+	if (const int32* Index = Indices.Find(Tag))
+	{
+		return *Index;
+	}
+	return Indices.Add(Tag, Indices.Num());
+}
+
+int32 FAbilityTagIndex::FindIndex(const FGameplayTag& Tag) const
+{
+	const int32* Index = Indices.Find(Tag);
+	return Index? *Index : INDEX_NONE;
+}
+
+
+FAbilityTagMask::FAbilityTagMask(const FGameplayTagContainer& Tags)
+{
+	FAbilityTagIndex& TagIndex = FAbilityTagIndex::Get();
+	for (const FGameplayTag& Tag : Tags)
+	{
+		Set(TagIndex.FindOrAddIndex(Tag));
+	}
+}
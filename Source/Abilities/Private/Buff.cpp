@@ -2,6 +2,45 @@
 
 #include "Buff.h"
 #include "AbilitiesComponent.h"
+#include "Misc/Helpers.h"
+
+
+void FBuffTagChanges::Compile(TArrayView<const FGameplayTagContainer* const> Added, TArrayView<const FGameplayTagContainer* const> Removed)
+{
+	Grants.Reset();
+	Revokes.Reset();
+
+	TMap<FGameplayTag, int32, TInlineSetAllocator<8>> NetGrants;
+	for (const FGameplayTagContainer* Container : Added)
+	{
+		for (const FGameplayTag& Tag : *Container)
+		{
+			++NetGrants.FindOrAdd(Tag, 0);
+		}
+	}
+	for (const FGameplayTagContainer* Container : Removed)
+	{
+		for (const FGameplayTag& Tag : *Container)
+		{
+			--NetGrants.FindOrAdd(Tag, 0);
+		}
+	}
+
+	for (const auto& It : NetGrants)
+	{
+		auto& Tags = (It.Value > 0)? Grants : Revokes;
+		for (int32 I = FMath::Abs(It.Value); I > 0; --I)
+		{
+			Tags.Add(It.Key);
+		}
+	}
+}
+
+void UBuff::PostLoad()
+{
+	Super::PostLoad();
+	CompileTagChanges();
+}
 
 #if WITH_EDITOR
 bool UBuff::CanEditChange(const UProperty* InProperty) const
@@ -11,36 +50,185 @@ bool UBuff::CanEditChange(const UProperty* InProperty) const
 	FName PropertyName = InProperty ? InProperty->GetFName() : NAME_None;
 	if (GET_MEMBER_NAME_CHECKED(UBuff, LifetimeDuration) == PropertyName)
 	{
-		bCanEdit &= bHasLifetime && !bStackable;
+		bCanEdit &= bHasLifetime && (!bStackable || bPerStackLifetime);
+	}
+	else if (GET_MEMBER_NAME_CHECKED(UBuff, bPerStackLifetime) == PropertyName)
+	{
+		bCanEdit &= bHasLifetime && bStackable;
+	}
+	else if (GET_MEMBER_NAME_CHECKED(UBuff, StackingPolicy) == PropertyName)
+	{
+		bCanEdit &= StackingGroup.IsValid();
 	}
 	return bCanEdit;
 }
+
+void UBuff::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	bTagChangesCompiled = false;
+}
 #endif //WITH_EDITOR
 
-void UBuff::DoApplyEffects(UAbilitiesComponent* Component, int32 Count) const
+void UBuff::CompileTagChanges() const
+{
+	if (!bTagChangesCompiled)
+	{
+		const FGameplayTagContainer* const AddedOnApply[] = { &TagsToApply, &ApplyTagsOnApply };
+		const FGameplayTagContainer* const RemovedOnApply[] = { &RemoveTagsOnApply };
+		ApplyTagChanges.Compile(AddedOnApply, RemovedOnApply);
+
+		const FGameplayTagContainer* const AddedOnRevert[] = { &ApplyTagsOnRevert };
+		const FGameplayTagContainer* const RemovedOnRevert[] = { &TagsToApply, &RemoveTagsOnRevert };
+		RevertTagChanges.Compile(AddedOnRevert, RemovedOnRevert);
+		bTagChangesCompiled = true;
+	}
+}
+
+void UBuff::DoApplyEffects(UAbilitiesComponent* Component, const FBuffSpec& Spec, int32 Count) const
+{
+	CompileTagChanges();
+	Component->ApplyTagChanges(ApplyTagChanges.Grants, ApplyTagChanges.Revokes);
+	if (Modifiers.Num() > 0)
+	{
+		Component->GetAttributes().SetModifiers(this, Modifiers, Count, Spec.Magnitude);
+	}
+	if (GetPeriod() > 0.f)
+	{
+		Component->SetPeriodicBuff(*this, true);
+	}
+
+	CallApplyEffects(Component, Spec, Count);
+}
+
+void UBuff::DoRevertEffects(UAbilitiesComponent* Component, const FBuffSpec& Spec, int32 Count) const
+{
+	CallRevertEffects(Component, Spec, Count);
+
+	if (GetPeriod() > 0.f)
+	{
+		Component->SetPeriodicBuff(*this, false);
+	}
+	if (Modifiers.Num() > 0)
+	{
+		Component->GetAttributes().RemoveModifiers(this);
+	}
+	CompileTagChanges();
+	Component->ApplyTagChanges(RevertTagChanges.Grants, RevertTagChanges.Revokes);
+}
+
+void UBuff::DoApplyStackDelta(UAbilitiesComponent* Component, const FBuffSpec& Spec, int32 OldCount, int32 NewCount) const
 {
-	Component->AddTags(TagsToApply);
-	Component->AddTags(ApplyTagsOnApply);
-	Component->RemoveTags(RemoveTagsOnApply);
+	TGuardValue<const FBuffSpec*> SpecScope{ EffectSpec, &Spec };
+	if (Modifiers.Num() > 0)
+	{
+		Component->GetAttributes().SetModifiers(this, Modifiers, NewCount, Spec.Magnitude);
+	}
+	if (IsBlueprintEventImplemented(EBuffBlueprintEvent::ApplyStackDelta))
+	{
+		EventApplyStackDelta(Component, OldCount, NewCount);
+	}
+	else
+	{
+		EventApplyStackDelta_Implementation(Component, OldCount, NewCount);
+	}
+}
 
-	EventApplyEffects(Component, Count);
+void UBuff::DoPeriod(UAbilitiesComponent* Component, int32 Count) const
+{
+	if (IsBlueprintEventImplemented(EBuffBlueprintEvent::Period))
+	{
+		EventOnPeriod(Component, Count);
+	}
+	else
+	{
+		EventOnPeriod_Implementation(Component, Count);
+	}
 }
 
-void UBuff::DoRevertEffects(UAbilitiesComponent* Component, int32 Count) const
+void UBuff::ApplyStackDelta(UAbilitiesComponent* Component, int32 OldCount, int32 NewCount) const
 {
-	EventRevertEffects(Component, Count);
+	const FBuffSpec Spec = EffectSpec? *EffectSpec : Component->GetBuffSpec(this);
+	CallRevertEffects(Component, Spec, OldCount);
+	CallApplyEffects(Component, Spec, NewCount);
+}
 
-	Component->RemoveTags(TagsToApply);
-	Component->AddTags(ApplyTagsOnRevert);
-	Component->RemoveTags(RemoveTagsOnRevert);
+bool UBuff::IsBlueprintEventImplemented(EBuffBlueprintEvent Event) const
+{
+	// Buff assets share their class CDO
+	auto* Default = GetClass()->GetDefaultObject<UBuff>();
+	if (!Default->bBlueprintEventsCached)
+	{
+		Default->BlueprintEvents = Default->FindBlueprintEvents();
+		Default->bBlueprintEventsCached = true;
+	}
+	return EnumHasAnyFlags(Default->BlueprintEvents, Event);
+}
+
+EBuffBlueprintEvent UBuff::FindBlueprintEvents() const
+{
+	static const TPair<FName, EBuffBlueprintEvent> BuffEvents[] = {
+		{ GET_FUNCTION_NAME_CHECKED(UBuff, EventApplyEffects),    EBuffBlueprintEvent::ApplyEffects },
+		{ GET_FUNCTION_NAME_CHECKED(UBuff, EventRevertEffects),   EBuffBlueprintEvent::RevertEffects },
+		{ GET_FUNCTION_NAME_CHECKED(UBuff, EventApplyStackDelta), EBuffBlueprintEvent::ApplyStackDelta },
+		{ GET_FUNCTION_NAME_CHECKED(UBuff, EventOnPeriod),        EBuffBlueprintEvent::Period }
+	};
+
+	const UClass* Class = GetClass();
+	EBuffBlueprintEvent Events = EBuffBlueprintEvent::None;
+	for (const auto& BuffEvent : BuffEvents)
+	{
+		if (IsEventImplementedInBlueprint(Class, BuffEvent.Key))
+		{
+			Events |= BuffEvent.Value;
+		}
+	}
+	return Events;
+}
+
+void UBuff::CallApplyEffects(UAbilitiesComponent* Component, const FBuffSpec& Spec, int32 Count) const
+{
+	// Blueprints read the spec from UAbilitiesComponent::GetBuffSpec
+	TGuardValue<const FBuffSpec*> SpecScope{ EffectSpec, &Spec };
+	if (IsBlueprintEventImplemented(EBuffBlueprintEvent::ApplyEffects))
+	{
+		EventApplyEffects(Component, Count);
+	}
+	else
+	{
+		EventApplyEffects_Implementation(Component, Count);
+	}
+}
+
+void UBuff::CallRevertEffects(UAbilitiesComponent* Component, const FBuffSpec& Spec, int32 Count) const
+{
+	TGuardValue<const FBuffSpec*> SpecScope{ EffectSpec, &Spec };
+	if (IsBlueprintEventImplemented(EBuffBlueprintEvent::RevertEffects))
+	{
+		EventRevertEffects(Component, Count);
+	}
+	else
+	{
+		EventRevertEffects_Implementation(Component, Count);
+	}
 }
 
 void UBuff::EventApplyEffects_Implementation(UAbilitiesComponent* Component, int32 Count) const
 {
-	ApplyEffects(Component, Count);
+	ApplySpecEffects(Component, EffectSpec? *EffectSpec : Component->GetBuffSpec(this), Count);
 }
 
 void UBuff::EventRevertEffects_Implementation(UAbilitiesComponent* Component, int32 Count) const
 {
-	RevertEffects(Component, Count);
+	RevertSpecEffects(Component, EffectSpec? *EffectSpec : Component->GetBuffSpec(this), Count);
+}
+
+void UBuff::EventApplyStackDelta_Implementation(UAbilitiesComponent* Component, int32 OldCount, int32 NewCount) const
+{
+	ApplyStackDelta(Component, OldCount, NewCount);
+}
+
+void UBuff::EventOnPeriod_Implementation(UAbilitiesComponent* Component, int32 Count) const
+{
+	OnPeriod(Component, Count);
 }
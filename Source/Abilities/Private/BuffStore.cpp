@@ -0,0 +1,308 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "BuffStore.h"
+
+
+int32 FBuffStore::Find(const UBuff* Buff) const
+{
+	if (!Buff || HashTable.Num() <= 0)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 Mask = HashTable.Num() - 1;
+	for (int32 I = GetHashIndex(Buff);; I = (I + 1) & Mask)
+	{
+		const int32 Slot = HashTable[I];
+		if (Slot == INDEX_NONE || Buffs[Slot] == Buff)
+		{
+			return Slot;
+		}
+	}
+}
+
+int32 FBuffStore::Add(UBuff* Buff, int32 Count)
+{
+	check(Buff && !Contains(Buff));
+
+	// Keep load factor under one half
+	if ((NumBuffs + 1) * 2 > HashTable.Num())
+	{
+		Rehash(FMath::Max(8, HashTable.Num() * 2));
+	}
+
+	UClass* Class = Buff->GetClass();
+	int32 ClassSlot = FindClassSlot(Class);
+	if (ClassSlot == INDEX_NONE)
+	{
+		ClassSlot = Classes.Add(Class);
+		SlotsByClass.AddDefaulted();
+	}
+
+	int32 GroupIndex = INDEX_NONE;
+	if (Buff->GetStackingGroup().IsValid())
+	{
+		int32& Index = GroupIndices.FindOrAdd(Buff->GetStackingGroup(), INDEX_NONE);
+		if (Index == INDEX_NONE)
+		{
+			Index = GroupSlots.Add(INDEX_NONE);
+		}
+		GroupIndex = Index;
+	}
+
+	int32 Slot;
+	if (FreeSlots.Num() > 0)
+	{
+		Slot = FreeSlots.Pop(false);
+		Buffs[Slot] = Buff;
+		Counts[Slot] = Count;
+		Magnitudes[Slot] = 1.f;
+		Levels[Slot] = 1;
+		ClassSlots[Slot] = ClassSlot;
+		SlotGroups[Slot] = GroupIndex;
+	}
+	else
+	{
+		Slot = Buffs.Add(Buff);
+		Counts.Add(Count);
+		Magnitudes.Add(1.f);
+		Instigators.AddDefaulted();
+		Levels.Add(1);
+		ClassSlots.Add(ClassSlot);
+		SlotGroups.Add(GroupIndex);
+		Generations.Add(0);
+	}
+	++NumBuffs;
+	++Version;
+	SlotsByClass[ClassSlot].Add(Slot);
+
+	if (GroupIndex != INDEX_NONE)
+	{
+		GroupSlots[GroupIndex] = Slot;
+	}
+
+	InsertHash(Slot);
+	AddTagIndex(Slot);
+	return Slot;
+}
+
+void FBuffStore::RemoveAt(int32 Slot)
+{
+	if (!IsValidSlot(Slot))
+	{
+		return;
+	}
+
+	RemoveHash(Slot);
+	RemoveTagIndex(Slot);
+	SlotsByClass[ClassSlots[Slot]].RemoveSingleSwap(Slot, false);
+	--NumBuffs;
+	++Version;
+
+	const int32 GroupIndex = SlotGroups[Slot];
+	if (GroupIndex != INDEX_NONE && GroupSlots[GroupIndex] == Slot)
+	{
+		GroupSlots[GroupIndex] = INDEX_NONE;
+	}
+
+	Buffs[Slot] = nullptr;
+	Counts[Slot] = 0;
+	Instigators[Slot] = nullptr;
+	++Generations[Slot];
+
+	if (NumBuffs <= 0)
+	{
+		// Generations are kept so that old handles stay invalid
+		FreeSlots.Reset();
+		for (int32 I = Buffs.Num() - 1; I >= 0; --I)
+		{
+			FreeSlots.Add(I);
+		}
+	}
+	else
+	{
+		FreeSlots.Add(Slot);
+	}
+}
+
+void FBuffStore::Empty()
+{
+	for (int32 Slot = 0; Slot < Buffs.Num(); ++Slot)
+	{
+		if (Buffs[Slot])
+		{
+			Buffs[Slot] = nullptr;
+			Counts[Slot] = 0;
+			Instigators[Slot] = nullptr;
+			++Generations[Slot];
+		}
+	}
+
+	FreeSlots.Reset(Buffs.Num());
+	for (int32 I = Buffs.Num() - 1; I >= 0; --I)
+	{
+		FreeSlots.Add(I);
+	}
+
+	for (FSlotList& ClassList : SlotsByClass)
+	{
+		ClassList.Reset();
+	}
+	for (int32& GroupSlot : GroupSlots)
+	{
+		GroupSlot = INDEX_NONE;
+	}
+	for (int32& Entry : HashTable)
+	{
+		Entry = INDEX_NONE;
+	}
+	// Keep tag lists allocated for the next buffs
+	for (auto& It : SlotsByExactTag)
+	{
+		It.Value.Reset();
+	}
+	for (auto& It : SlotsByTag)
+	{
+		It.Value.Reset();
+	}
+	NumBuffs = 0;
+	++Version;
+}
+
+void FBuffStore::GetBuffsOfClass(const UClass* Class, TArray<FBuffCount>& OutBuffs) const
+{
+	const int32 ClassSlot = FindClassSlot(Class);
+	if (ClassSlot == INDEX_NONE)
+	{
+		return;
+	}
+
+	const FSlotList& Slots = SlotsByClass[ClassSlot];
+	OutBuffs.Reserve(OutBuffs.Num() + Slots.Num());
+	for (const int32 Slot : Slots)
+	{
+		OutBuffs.Add(GetBuffCount(Slot));
+	}
+}
+
+void FBuffStore::GetAllBuffs(TArray<FBuffCount>& OutBuffs) const
+{
+	OutBuffs.Reserve(OutBuffs.Num() + NumBuffs);
+	ForEachSlot([this, &OutBuffs](int32 Slot)
+	{
+		OutBuffs.Add(GetBuffCount(Slot));
+	});
+}
+
+void FBuffStore::GetBuffsByTag(const FGameplayTag& Tag, bool bExact, TArray<FBuffCount>& OutBuffs) const
+{
+	if (const FSlotList* Slots = FindSlotsByTag(Tag, bExact))
+	{
+		OutBuffs.Reserve(OutBuffs.Num() + Slots->Num());
+		for (const int32 Slot : *Slots)
+		{
+			OutBuffs.Add(GetBuffCount(Slot));
+		}
+	}
+}
+
+int32 FBuffStore::CountBuffsByTag(const FGameplayTag& Tag, bool bExact) const
+{
+	const FSlotList* Slots = FindSlotsByTag(Tag, bExact);
+	return Slots? Slots->Num() : 0;
+}
+
+SIZE_T FBuffStore::GetAllocatedSize() const
+{
+	return Buffs.GetAllocatedSize() + Counts.GetAllocatedSize() + ClassSlots.GetAllocatedSize() +
+		Magnitudes.GetAllocatedSize() + Instigators.GetAllocatedSize() + Levels.GetAllocatedSize() +
+		GroupIndices.GetAllocatedSize() + GroupSlots.GetAllocatedSize() + SlotGroups.GetAllocatedSize() +
+		Generations.GetAllocatedSize() + FreeSlots.GetAllocatedSize() + Classes.GetAllocatedSize() +
+		SlotsByClass.GetAllocatedSize() + HashTable.GetAllocatedSize() +
+		SlotsByExactTag.GetAllocatedSize() + SlotsByTag.GetAllocatedSize();
+}
+
+void FBuffStore::InsertHash(int32 Slot)
+{
+	const int32 Mask = HashTable.Num() - 1;
+	int32 I = GetHashIndex(Buffs[Slot]);
+	while (HashTable[I] != INDEX_NONE)
+	{
+		I = (I + 1) & Mask;
+	}
+	HashTable[I] = Slot;
+}
+
+void FBuffStore::RemoveHash(int32 Slot)
+{
+	const int32 Mask = HashTable.Num() - 1;
+	int32 I = GetHashIndex(Buffs[Slot]);
+	while (HashTable[I] != Slot)
+	{
+		I = (I + 1) & Mask;
+	}
+
+	// Shift back following entries so that probing never finds a gap before them
+	for (int32 J = (I + 1) & Mask; HashTable[J] != INDEX_NONE; J = (J + 1) & Mask)
+	{
+		const int32 Home = GetHashIndex(Buffs[HashTable[J]]);
+		const bool bHomeBetween = I <= J? (I < Home && Home <= J) : (I < Home || Home <= J);
+		if (!bHomeBetween)
+		{
+			HashTable[I] = HashTable[J];
+			I = J;
+		}
+	}
+	HashTable[I] = INDEX_NONE;
+}
+
+void FBuffStore::Rehash(int32 NewSize)
+{
+	HashTable.Init(INDEX_NONE, NewSize);
+	ForEachSlot([this](int32 Slot)
+	{
+		InsertHash(Slot);
+	});
+}
+
+void FBuffStore::AddTagIndex(int32 Slot)
+{
+	const FGameplayTagContainer& Tags = Buffs[Slot]->GetTags();
+	if (Tags.Num() <= 0)
+	{
+		return;
+	}
+
+	for (const FGameplayTag& Tag : Tags)
+	{
+		SlotsByExactTag.FindOrAdd(Tag).Add(Slot);
+	}
+	for (const FGameplayTag& Tag : Tags.GetGameplayTagParents())
+	{
+		SlotsByTag.FindOrAdd(Tag).Add(Slot);
+	}
+}
+
+void FBuffStore::RemoveTagIndex(int32 Slot)
+{
+	const FGameplayTagContainer& Tags = Buffs[Slot]->GetTags();
+	if (Tags.Num() <= 0)
+	{
+		return;
+	}
+
+	for (const FGameplayTag& Tag : Tags)
+	{
+		if (FSlotList* Slots = SlotsByExactTag.Find(Tag))
+		{
+			Slots->RemoveSingleSwap(Slot, false);
+		}
+	}
+	for (const FGameplayTag& Tag : Tags.GetGameplayTagParents())
+	{
+		if (FSlotList* Slots = SlotsByTag.Find(Tag))
+		{
+			Slots->RemoveSingleSwap(Slot, false);
+		}
+	}
+}
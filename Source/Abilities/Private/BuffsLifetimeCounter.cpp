@@ -9,6 +9,34 @@
 #include "AbilitiesComponent.h"
 
 
+void FBuffStackLifetimes::Push(float EndTime)
+{
+	const int32 Capacity = EndTimes.Num();
+	if (NumStacks >= Capacity)
+	{
+		// Grow and unwrap the stacks from the start
+		TArray<float, TInlineAllocator<4>> NewEndTimes;
+		NewEndTimes.SetNumUninitialized(FMath::Max(Capacity * 2, 4));
+		for (int32 I = 0; I < NumStacks; ++I)
+		{
+			NewEndTimes[I] = Get(I);
+		}
+		EndTimes = MoveTemp(NewEndTimes);
+		Head = 0;
+	}
+
+	EndTimes[(Head + NumStacks) & (EndTimes.Num() - 1)] = EndTime;
+	++NumStacks;
+}
+
+void FBuffStackLifetimes::PopFront(int32 Count)
+{
+	Count = FMath::Min(Count, NumStacks);
+	Head = (Head + Count) & (EndTimes.Num() - 1);
+	NumStacks -= Count;
+}
+
+
 void FBuffsLifetimeCounter::Start(const TSet<FBuffCount>& Buffs)
 {
 	auto* Component = GetOwner<UAbilitiesComponent>();
@@ -23,31 +51,103 @@ void FBuffsLifetimeCounter::Start(const TSet<FBuffCount>& Buffs)
 	for (const FBuffCount& BuffCount : Buffs)
 	{
 		const float Duration = BuffCount.Buff->GetLifetimeDuration();
-		if (Duration > 0.f)
+		if (BuffCount.Buff->HasPerStackLifetime())
+		{
+			// New stacks expire last, so end times stay sorted
+			FBuffStackLifetimes& Stacks = LifetimePerStack.FindOrAdd(BuffCount.Buff);
+			const bool bWasEmpty = Stacks.Num() <= 0;
+			for (int32 I = 0; I < BuffCount.Count; ++I)
+			{
+				Stacks.Push(GameTime + Duration);
+			}
+
+			if (bWasEmpty)
+			{
+				ExpirationQueue.HeapPush({ Stacks.Front(), BuffCount.Buff });
+			}
+		}
+		else if (Duration > 0.f)
 		{
 			float& Lifetime = LifetimePerBuff.FindOrAdd(BuffCount.Buff);
 			Lifetime = GameTime + Duration;
+
+			// A previous entry of this buff will be outdated
+			ExpirationQueue.HeapPush({ Lifetime, BuffCount.Buff });
+		}
+	}
+}
+
+void FBuffsLifetimeCounter::Refresh(const TSet<FBuffCount>& Buffs)
+{
+	const float GameTime = GetWorld()->GetTimeSeconds();
+	for (const FBuffCount& BuffCount : Buffs)
+	{
+		const float EndTime = GameTime + BuffCount.Buff->GetLifetimeDuration();
+		if (FBuffStackLifetimes* Stacks = LifetimePerStack.Find(BuffCount.Buff))
+		{
+			// Queued entries of previous end times will be outdated
+			const int32 NumStacks = Stacks->Num();
+			Stacks->PopFront(NumStacks);
+			for (int32 I = 0; I < NumStacks; ++I)
+			{
+				Stacks->Push(EndTime);
+			}
+			ExpirationQueue.HeapPush({ EndTime, BuffCount.Buff });
+		}
+		else if (float* Lifetime = LifetimePerBuff.Find(BuffCount.Buff))
+		{
+			*Lifetime = EndTime;
+			ExpirationQueue.HeapPush({ EndTime, BuffCount.Buff });
 		}
 	}
 }
 
 void FBuffsLifetimeCounter::Reset(const TSet<FBuffCount>& Buffs)
 {
+	// Queue entries of removed buffs are ignored when they expire
 	for (const FBuffCount& BuffCount : Buffs)
 	{
-		LifetimePerBuff.Remove(BuffCount.Buff);
+		FBuffStackLifetimes* Stacks = LifetimePerStack.Find(BuffCount.Buff);
+		if (!Stacks)
+		{
+			LifetimePerBuff.Remove(BuffCount.Buff);
+			continue;
+		}
+
+		// Removed stacks are the oldest ones
+		Stacks->PopFront(BuffCount.Count);
+		if (Stacks->Num() <= 0)
+		{
+			LifetimePerStack.Remove(BuffCount.Buff);
+		}
+		else
+		{
+			ExpirationQueue.HeapPush({ Stacks->Front(), BuffCount.Buff });
+		}
+	}
+
+	if (!HasPending())
+	{
+		// Only outdated entries left
+		ResetAll();
 	}
-	LifetimePerBuff.Shrink();
 }
 
 void FBuffsLifetimeCounter::ResetAll()
 {
 	LifetimePerBuff.Empty();
+	LifetimePerStack.Empty();
+	ExpirationQueue.Empty();
 }
 
 
 float FBuffsLifetimeCounter::GetRemaining(const UBuff* Buff) const
 {
+	if (const FBuffStackLifetimes* Stacks = LifetimePerStack.Find(Buff))
+	{
+		const float GameTime = GetWorld()->GetTimeSeconds();
+		return FMath::Max(Stacks->Front() - GameTime, 0.f);
+	}
 	if (const float* FinalTime = LifetimePerBuff.Find(Buff))
 	{
 		const float GameTime = GetWorld()->GetTimeSeconds();
@@ -56,6 +156,48 @@ float FBuffsLifetimeCounter::GetRemaining(const UBuff* Buff) const
 	return 0.f;
 }
 
+void FBuffsLifetimeCounter::GetRemainingTimes(const UBuff* Buff, TArray<float>& OutRemaining) const
+{
+	const float GameTime = GetWorld()->GetTimeSeconds();
+	if (const FBuffStackLifetimes* Stacks = LifetimePerStack.Find(Buff))
+	{
+		for (int32 I = 0; I < Stacks->Num(); ++I)
+		{
+			OutRemaining.Add(FMath::Max(Stacks->Get(I) - GameTime, 0.f));
+		}
+	}
+	else if (const float* FinalTime = LifetimePerBuff.Find(Buff))
+	{
+		OutRemaining.Add(FMath::Max(*FinalTime - GameTime, 0.f));
+	}
+}
+
+void FBuffsLifetimeCounter::SetRemainingTimes(UBuff* Buff, TArrayView<const float> Remaining)
+{
+	if (Remaining.Num() <= 0)
+	{
+		return;
+	}
+
+	// Previous queue entries become outdated
+	const float GameTime = GetWorld()->GetTimeSeconds();
+	if (FBuffStackLifetimes* Stacks = LifetimePerStack.Find(Buff))
+	{
+		const int32 NumStacks = Stacks->Num();
+		Stacks->PopFront(NumStacks);
+		for (int32 I = 0; I < NumStacks; ++I)
+		{
+			Stacks->Push(GameTime + Remaining[FMath::Min(I, Remaining.Num() - 1)]);
+		}
+		ExpirationQueue.HeapPush({ Stacks->Front(), Buff });
+	}
+	else if (float* FinalTime = LifetimePerBuff.Find(Buff))
+	{
+		*FinalTime = GameTime + Remaining[0];
+		ExpirationQueue.HeapPush({ *FinalTime, Buff });
+	}
+}
+
 void FBuffsLifetimeCounter::Tick()
 {
 	auto* Component = GetOwner<UAbilitiesComponent>();
@@ -66,13 +208,38 @@ void FBuffsLifetimeCounter::Tick()
 
 	const float GameTime = GetWorld()->GetTimeSeconds();
 
+	// Check if time of removal has arrived
+	if (ExpirationQueue.Num() <= 0 || ExpirationQueue.HeapTop().EndTime > GameTime)
+	{
+		return;
+	}
+
 	TSet<UBuff*> BuffsToRemove;
-	for (const auto& Lifetime : LifetimePerBuff)
+	TSet<FBuffCount> StacksToRemove;
+	while (ExpirationQueue.Num() > 0 && ExpirationQueue.HeapTop().EndTime <= GameTime)
 	{
-		// Check if time of removal has arrived
-		if (Lifetime.Value <= GameTime)
+		FBuffLifetimeEntry Entry;
+		ExpirationQueue.HeapPop(Entry, false);
+
+		if (const FBuffStackLifetimes* Stacks = LifetimePerStack.Find(Entry.Buff))
 		{
-			BuffsToRemove.Add(Lifetime.Key);
+			if (Stacks->Front() == Entry.EndTime)
+			{
+				// Stacks are popped when removed from the component
+				int32 NumExpired = 0;
+				while (NumExpired < Stacks->Num() && Stacks->Get(NumExpired) <= GameTime)
+				{
+					++NumExpired;
+				}
+				StacksToRemove.Add({ Entry.Buff, NumExpired });
+			}
+			continue;
+		}
+
+		const float* const EndTime = LifetimePerBuff.Find(Entry.Buff);
+		if (EndTime && *EndTime == Entry.EndTime)
+		{
+			BuffsToRemove.Add(Entry.Buff);
 		}
 	}
 
@@ -80,4 +247,8 @@ void FBuffsLifetimeCounter::Tick()
 	{
 		Component->RemoveAllBuffs(BuffsToRemove);
 	}
+	if (StacksToRemove.Num() > 0)
+	{
+		Component->RemoveBuffs(StacksToRemove);
+	}
 }
@@ -0,0 +1,95 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "ReplicatedBuffList.h"
+
+#include "AbilitiesComponent.h"
+
+
+void FReplicatedBuff::PreReplicatedRemove(const FReplicatedBuffList& List)
+{
+	if (UAbilitiesComponent* Owner = List.GetOwner())
+	{
+		Owner->OnReplicatedBuffChanged(GetSpec(), 0);
+	}
+}
+
+void FReplicatedBuff::PostReplicatedAdd(const FReplicatedBuffList& List)
+{
+	ReceivedRefreshes = NumRefreshes;
+	if (UAbilitiesComponent* Owner = List.GetOwner())
+	{
+		Owner->OnReplicatedBuffChanged(GetSpec(), Count);
+	}
+}
+
+void FReplicatedBuff::PostReplicatedChange(const FReplicatedBuffList& List)
+{
+	const bool bRefreshed = ReceivedRefreshes != NumRefreshes;
+	ReceivedRefreshes = NumRefreshes;
+	if (UAbilitiesComponent* Owner = List.GetOwner())
+	{
+		Owner->OnReplicatedBuffChanged(GetSpec(), Count);
+		if (bRefreshed)
+		{
+			Owner->OnReplicatedBuffRefreshed(Buff);
+		}
+	}
+}
+
+
+void FReplicatedBuffList::SetCount(const FBuffSpec& Spec, int32 Count)
+{
+	UBuff* Buff = Spec.Buff;
+	const int32 Index = Items.IndexOfByPredicate([Buff](const FReplicatedBuff& Item)
+	{
+		return Item.Buff == Buff;
+	});
+
+	if (Count <= 0)
+	{
+		if (Index != INDEX_NONE)
+		{
+			Items.RemoveAtSwap(Index, 1, false);
+			MarkArrayDirty();
+		}
+		return;
+	}
+
+	if (Index == INDEX_NONE)
+	{
+		MarkItemDirty(Items.Add_GetRef({ Spec, Count }));
+		return;
+	}
+
+	FReplicatedBuff& Item = Items[Index];
+	if (Item.Count != Count || Item.Magnitude != Spec.Magnitude || Item.Level != Spec.Level)
+	{
+		// Fields are set one by one to keep the replication id of the item
+		Item.Count = Count;
+		Item.Magnitude = Spec.Magnitude;
+		Item.Level = Spec.Level;
+		MarkItemDirty(Item);
+	}
+}
+
+void FReplicatedBuffList::Refresh(const UBuff* Buff)
+{
+	FReplicatedBuff* Item = Items.FindByPredicate([Buff](const FReplicatedBuff& Other)
+	{
+		return Other.Buff == Buff;
+	});
+	if (Item)
+	{
+		++Item->NumRefreshes;
+		MarkItemDirty(*Item);
+	}
+}
+
+void FReplicatedBuffList::Empty()
+{
+	if (Items.Num() > 0)
+	{
+		Items.Empty();
+		MarkArrayDirty();
+	}
+}
@@ -11,8 +11,12 @@
 #include "Ability.h"
 #include "Buff.h"
 #include "AbilitiesCooldownCounter.h"
+#include "AbilityAttributeSet.h"
+#include "AbilityAvailabilityCache.h"
+#include "AbilityTagCounter.h"
 #include "BuffsLifetimeCounter.h"
-#include "BuffTypeContainer.h"
+#include "BuffStore.h"
+#include "ReplicatedBuffList.h"
 #include "Misc/Helpers.h"
 #include "AbilitiesComponent.generated.h"
 
@@ -20,9 +24,25 @@
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnBuffsAppliedDelegate, const TSet<FBuffCount>&, Buffs);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnBuffsRemovedDelegate, const TSet<FBuffCount>&, Buffs);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnTagsChangedDelegate);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnTagsDeltaDelegate, const FAbilityTagsDelta& /*Delta*/);
+
+
+// Net buff changes of a frame. Views are only valid during the broadcast.
+struct FBuffChanges
+{
+	// Buffs not applied before, with their current count
+	TArrayView<const FBuffCount> Applied;
+	// Buffs not applied anymore, with the count they had
+	TArrayView<const FBuffCount> Removed;
+	// Buffs still applied with a different count, with their current count
+	TArrayView<const FBuffCount> StackChanged;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnBuffsChangedDelegate, const FBuffChanges& /*Changes*/);
 
 
 class UAbilitiesComponent;
+class UAbilitiesWorldSubsystem;
 
 // Defines how buffs replicate at compile-time
 // See UAbilitiesComponent::BuffReplication
@@ -54,6 +74,28 @@ struct FCancelInputReturn
 	bool bAbilityCancelled = false;
 };
 
+// Buff applied locally by the owning client, waiting for the server
+USTRUCT()
+struct FPredictedBuff
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FBuffPredictionKey Key;
+
+	UPROPERTY()
+	FBuffSpec Spec;
+
+	UPROPERTY()
+	int32 Count = 0;
+
+
+	FPredictedBuff() {}
+	FPredictedBuff(const FBuffPredictionKey& Key, const FBuffSpec& Spec, int32 Count)
+		: Key(Key), Spec(Spec), Count(Count)
+	{}
+};
+
 
 /** Component that owns abilities and ability effects */
 UCLASS(Blueprintable, ClassGroup = (Gameplay), meta = (BlueprintSpawnableComponent))
@@ -62,6 +104,11 @@ class ABILITIES_API UAbilitiesComponent : public UActorComponent
 	GENERATED_BODY()
 
 	friend UAbility;
+	friend UBuff;
+	friend UAbilitiesWorldSubsystem;
+	friend FAbilitiesCooldownCounter;
+	friend struct FAbilityTagMutationScope;
+	friend FReplicatedBuff;
 
 
 	/************************************************************************/
@@ -70,17 +117,29 @@ class ABILITIES_API UAbilitiesComponent : public UActorComponent
 
 	// Compile-time settings
 	// What model of buff replication to use. Should it not replicate? Only to owning client or all clients?
+	// Used by buffs with Default replication policy.
 	static constexpr EBuffReplicationMode BuffReplication = EBuffReplicationMode::AllClients;
 
 
 protected:
 
-	/** Tags that the system must have to able to execute an ability. Can only be edited from server. */
+	/** If true, this component is ticked in batch by UAbilitiesWorldSubsystem and only while it has work to do.
+	 * Otherwise it uses its own tick function every frame.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "Abilities")
+	bool bTickWithSubsystem = true;
+
+	/** Tags that the system must have to able to execute an ability. Can only be edited from server.
+	 * Cache of the tags granted at least once in TagCounts.
+	 */
 	UPROPERTY(ReplicatedUsing="OnRep_Tags", EditDefaultsOnly, BlueprintReadOnly, Category = "Abilities")
 	FGameplayTagContainer Tags;
 
+	// Number of times each tag has been granted
+	FAbilityTagCounter TagCounts;
+
 	UFUNCTION()
-	void OnRep_Tags();
+	void OnRep_Tags(const FGameplayTagContainer& PreviousTags);
 
 
 	/** Begin ABILITIES */
@@ -105,17 +164,56 @@ protected:
 
 	UPROPERTY()
 	FAbilitiesCooldownCounter Cooldowns;
+
+	/** If true, CanCast and CanActivate results without a container are cached until tags, cooldowns or ability
+	 * states change. Conditions depending on anything else must call InvalidateAvailability.
+	 * Cached results check the whole state transition, including tags and cooldowns.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "Abilities")
+	bool bCacheAvailability = false;
 	/** End ABILITIES */
 
 
 	/** Begin BUFFS */
 
-	// Map containing all buffs and their amounts (if stackable)
+	// All buffs and their amounts (if stackable)
 	UPROPERTY()
-	TSet<FBuffCount> Buffs;
+	FBuffStore Buffs;
 
-	UPROPERTY()
-	TSet<FBuffTypeContainer> BuffsByClass;
+	// Buffs sent to all clients. See UBuff::Replication
+	UPROPERTY(Replicated)
+	FReplicatedBuffList ReplicatedBuffs;
+
+	// Buffs only sent to the owning client
+	UPROPERTY(Replicated)
+	FReplicatedBuffList OwnerReplicatedBuffs;
+
+	// Buffs predicted by the owning client and not yet confirmed by the server
+	UPROPERTY(Transient)
+	TArray<FPredictedBuff> PredictedBuffs;
+
+	// Last request of each ability handled by the server. Replicated with buff counts, so that
+	// predictions are confirmed once the counts they were applied to have been received.
+	UPROPERTY(ReplicatedUsing = "OnRep_PredictionAcks")
+	TArray<FBuffPredictionKey> PredictionAcks;
+
+	// Changes made by ApplyBuffsToMany or RemoveBuffsFromMany not notified yet
+	TSet<FBuffCount> DeferredAppliedBuffs;
+	TSet<FBuffCount> DeferredRemovedBuffs;
+	bool bBuffFlushPending = false;
+
+	/** If true, buff events are broadcasted once per frame with the net changes, instead of after every change.
+	 * See OnBuffsChanged.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "Buffs")
+	bool bCoalesceBuffEvents = false;
+
+	// Count of each buff changed this frame before its first change. Only if coalescing events.
+	TMap<UBuff*, int32> CoalescedOldCounts;
+	TArray<FBuffCount> CoalescedApplied;
+	TArray<FBuffCount> CoalescedRemoved;
+	TArray<FBuffCount> CoalescedStackChanged;
+	bool bBroadcastingBuffEvents = false;
 
 	// Buffs applied at initialize for the first time
 	UPROPERTY(EditAnywhere, Category = "Buffs", meta=(DisplayName = "Buffs"))
@@ -123,9 +221,24 @@ protected:
 
 	UPROPERTY()
 	FBuffsLifetimeCounter BuffLifetimes;
+
+	// Buffs as returned by GetAllBuffs. Rebuilt when the version of the store changes.
+	mutable TSet<FBuffCount> CachedAllBuffs;
+	mutable uint32 CachedAllBuffsVersion = 0;
 	/** End BUFFS */
 
 
+	/** Begin ATTRIBUTES */
+
+	// Base value of each attribute. Not replicated, clients start with the same defaults.
+	UPROPERTY(EditDefaultsOnly, Category = "Attributes")
+	TMap<FGameplayTag, float> BaseAttributes;
+
+	// Attribute values aggregated from base values and buff modifiers
+	FAbilityAttributeSet Attributes;
+	/** End ATTRIBUTES */
+
+
 	UPROPERTY(Transient)
 	TMap<FName, UClass*> PressedInputs;
 
@@ -134,6 +247,27 @@ private:
 	UPROPERTY(Transient)
 	bool bIsTearingDown = false;
 
+	// Index inside UAbilitiesWorldSubsystem while registered for batched ticking
+	int32 SubsystemTickIndex = INDEX_NONE;
+
+	// Number of open FAbilityTagMutationScope
+	int32 TagMutationDepth = 0;
+
+	// True if tags changed inside a mutation scope
+	bool bPendingTagsChanged = false;
+
+	// Tags added and removed since last notification
+	FAbilityTagsDelta PendingTagsDelta;
+
+	// Running abilities that will be interrupted when they receive a tag
+	TMap<FGameplayTag, TArray<UAbility*, TInlineAllocator<2>>> InterruptListeners;
+
+	// Availability of each ability by its index in AllAbilities
+	FAbilityAvailabilityCache Availability;
+
+	// True if abilities were equipped or unequipped since availability slots were assigned
+	bool bAvailabilitySlotsDirty = true;
+
 public:
 
 	/** Begin EVENTS */
@@ -146,6 +280,12 @@ public:
 
 	UPROPERTY(BlueprintAssignable, Category = Buffs)
 	FOnTagsChangedDelegate OnTagsChanged;
+
+	// Native version of OnTagsChanged receiving only the tags that changed
+	FOnTagsDeltaDelegate OnTagsDelta;
+
+	// Net buff changes, once per frame. Only if bCoalesceBuffEvents is enabled.
+	FOnBuffsChangedDelegate OnBuffsChanged;
 	/** End EVENTS */
 
 
@@ -161,10 +301,36 @@ public:
 protected:
 
 	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
+	virtual void RegisterComponentTickFunctions(bool bRegister) override;
 	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
 
+public:
+
+	// Switches between batched ticking (UAbilitiesWorldSubsystem) and a tick function per component
+	void SetTickWithSubsystem(bool bEnabled);
+	bool IsTickingWithSubsystem() const { return bTickWithSubsystem; }
+
+protected:
+
+	// Updates buff lifetimes, cooldowns and ticking abilities
+	void BatchedTick(float DeltaTime);
+
+	// @return true if there is anything to update on tick
+	bool HasTickWork() const;
+
+	// Registers or unregisters this component from batched ticking depending on its pending work
+	void UpdateTickRegistration();
+
+private:
+
+	void AddTickingAbility(UAbility* Ability);
+	void RemoveTickingAbility(UAbility* Ability);
+
+protected:
+
 	virtual bool ReplicateSubobjects(class UActorChannel *Channel, class FOutBunch *Bunch, FReplicationFlags *RepFlags) override;
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
@@ -246,6 +412,22 @@ public:
 		return CanActivate(Class, {});
 	}
 
+	// @return all equipped abilities that can cast now
+	UFUNCTION(BlueprintCallable, Category = "AbilityComponent|Abilities")
+	TArray<UAbility*> GetCastableAbilities();
+	void GetCastableAbilities(TArray<UAbility*>& OutAbilities);
+
+	void SetCacheAvailability(bool bEnabled)
+	{
+		bCacheAvailability = bEnabled;
+		InvalidateAvailability();
+	}
+
+	// Forces cached availability of all abilities to be evaluated again. See bCacheAvailability
+	UFUNCTION(BlueprintCallable, Category = "AbilityComponent|Abilities")
+	void InvalidateAvailability();
+	void InvalidateAvailability(const UAbility& Ability);
+
 	// @return true if any ability of a class is executing
 	UFUNCTION(BlueprintPure, Category = "AbilityComponent|Abilities")
 	bool IsRunning(TSubclassOf<UAbility> Class) const;
@@ -265,21 +447,39 @@ public:
 	UFUNCTION()
 	void OnRep_AllAbilities();
 
+	UFUNCTION()
+	void OnRep_PredictionAcks();
+
 private:
 
 	void InternalEquipAbility(UClass* Class);
+	// Ends abilities and removes their prediction acks once
+	void InternalUnequipAbilities(TArrayView<const TSubclassOf<UAbility>> Classes);
+
+	// Evaluates invalidated abilities in the availability cache
+	void UpdateAvailability();
+
+	// @return true if an ability is still equipped on this component
+	static bool IsEquippedInstance(const UAbility* Ability);
+
+	// @return true if an ability can go to Cast (or Activation if it has no cast) or Activation
+	static bool CheckCanCast(UAbility& Ability, const FStructContainer& Container);
+	static bool CheckCanActivate(UAbility& Ability, const FStructContainer& Container);
 
 
 public:
 
 	/** Begin TAGS */
 
+	// Grants a tag. Tags granted multiple times are only removed once all grants are removed.
 	UFUNCTION(BlueprintCallable, Category = "AbilityComponent|Tags")
 	void AddTag(const FGameplayTag& NewTag);
 
 	UFUNCTION(BlueprintCallable, Category = "AbilityComponent|Tags")
 	void AddTags(const FGameplayTagContainer& NewTags);
 
+	// Removes one grant of a tag
+	// @return true if the tag is not granted anymore
 	UFUNCTION(BlueprintCallable, Category = "AbilityComponent|Tags")
 	bool RemoveTag(const FGameplayTag& NewTag);
 
@@ -288,15 +488,38 @@ public:
 
 	const FGameplayTagContainer& GetTags() const { return Tags; }
 
+	// Grants and revokes many tags as one change. Tags can be repeated to grant or revoke them more than once.
+	void ApplyTagChanges(TArrayView<const FGameplayTag> Grants, TArrayView<const FGameplayTag> Revokes);
+
+	// @return explicit tags as a mask for fast requirement checks
+	const FAbilityTagMask& GetTagMask() const { return TagCounts.GetMask(); }
+
+	// @return number of times a tag has been granted
+	UFUNCTION(BlueprintPure, Category = "AbilityComponent|Tags")
+	int32 GetTagCount(const FGameplayTag& Tag) const;
+
 protected:
 
+	// Notifies listeners of a tag change, or delays it until the last mutation scope ends
 	void NotifyTagsChanged();
+
+	// @return number of tags abilities are waiting for to be interrupted
+	int32 GetNumInterruptListeners() const { return InterruptListeners.Num(); }
+
+private:
+
+	void BroadcastTagsChanged();
+
+	// Starts or stops interrupting an ability when it receives any of its InterruptWithTags
+	void AddInterruptListener(UAbility& Ability);
+	void RemoveInterruptListener(UAbility& Ability);
 	/** End TAGS */
 
 
 	/** Begin BUFFS */
 public:
 
+	// @return true if any buff was applied, or refreshed by its stacking group
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "AbilityComponent|Buffs")
 	FORCEINLINE bool ApplyBuff(FBuffCount Buff)
 	{
@@ -309,6 +532,12 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "AbilityComponent|Buffs")
 	bool ApplySingleBuffs(const TSet<UBuff*>& InBuffs);
 
+	/** Applies a buff with runtime parameters.
+	 * A buff holds a single spec, so stacking an applied buff replaces the spec of all its stacks.
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "AbilityComponent|Buffs")
+	bool ApplyBuffSpec(const FBuffSpec& Spec, int32 Count = 1);
+
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "AbilityComponent|Buffs")
 	FORCEINLINE bool RemoveBuff(FBuffCount Buff)
 	{
@@ -325,6 +554,28 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "AbilityComponent|Buffs")
 	bool RemoveAllBuffs(const TSet<UBuff*>& InBuffs);
 
+	/** Applies the same buffs to many components at once.
+	 * Buffs are validated once and notifications are deferred to one flush per component on next frame.
+	 * Deferred notifications are sent earlier if the component changes its buffs in any other way.
+	 * @return number of components that received any buff
+	 */
+	static int32 ApplyBuffsToMany(TArrayView<UAbilitiesComponent* const> Targets, const TSet<FBuffCount>& InBuffs);
+
+	// Removes the same buffs from many components at once. See ApplyBuffsToMany
+	static int32 RemoveBuffsFromMany(TArrayView<UAbilitiesComponent* const> Targets, const TSet<FBuffCount>& InBuffs);
+
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "AbilityComponent|Buffs", meta = (DisplayName = "Apply Buffs To Many"))
+	static int32 ApplyBuffsToTargets(const TArray<UAbilitiesComponent*>& Targets, const TSet<FBuffCount>& InBuffs)
+	{
+		return ApplyBuffsToMany(Targets, InBuffs);
+	}
+
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "AbilityComponent|Buffs", meta = (DisplayName = "Remove Buffs From Many"))
+	static int32 RemoveBuffsFromTargets(const TArray<UAbilitiesComponent*>& Targets, const TSet<FBuffCount>& InBuffs)
+	{
+		return RemoveBuffsFromMany(Targets, InBuffs);
+	}
+
 	// Remove all buffs with "Tag" inside Identifying tags
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "AbilityComponent|Buffs")
 	bool RemoveBuffsByTag(FGameplayTag Tag, bool bExact = false);
@@ -344,20 +595,48 @@ public:
 	UFUNCTION(BlueprintPure, Category = "AbilityComponent|Buffs")
 	int32 GetBuffCount(const UBuff* Buff) const;
 
+	/** Applies a buff as part of a predicted ability state change. See UAbilityBase::ApplyPredictedBuff
+	 * @network Server applies it. Owning client applies it locally until the request is acknowledged or rejected.
+	 */
+	bool ApplyPredictedBuff(const FBuffPredictionKey& Key, const FBuffSpec& Spec, int32 Count = 1);
+
+	// Server handled an ability request and all the ones before it. Acknowledged to the owning client.
+	void AcknowledgePredictions(const FBuffPredictionKey& Key);
+
+	// Drops buffs predicted by acknowledged requests, since replicated counts already include what server applied
+	void ConfirmPredictedBuffs(const FBuffPredictionKey& Key);
+
+	// Reverts buffs predicted by a rejected request. Reverts all of the ability if RequestId is 0
+	void RevertPredictedBuffs(const UAbilityBase* Ability, uint32 RequestId = 0);
+
+	int32 GetNumPredictedBuffs() const { return PredictedBuffs.Num(); }
+
+	// @return the spec an applied buff was applied with, or a default spec if not applied
+	UFUNCTION(BlueprintPure, Category = "AbilityComponent|Buffs")
+	FBuffSpec GetBuffSpec(const UBuff* Buff) const;
+
 	UFUNCTION(BlueprintPure, Category = "AbilityComponent|Buffs")
 	bool HasBuffOfClass(TSubclassOf<UBuff> Class) const
 	{
-		return BuffsByClass.Contains({ Class.Get() });
+		return Buffs.HasClass(Class.Get());
 	}
 
 	UFUNCTION(BlueprintPure, Category = "AbilityComponent|Buffs")
 	void GetBuffsOfClass(TSubclassOf<UBuff> Class, TSet<FBuffCount>& OutBuffs) const;
+	void GetBuffsOfClass(TSubclassOf<UBuff> Class, TArray<FBuffCount>& OutBuffs) const;
 
+	// Built again only after buffs or their counts change
 	UFUNCTION(BlueprintPure, Category = "AbilityComponent|Buffs")
-	const TSet<FBuffCount>& GetAllBuffs() const
-	{
-		return Buffs;
-	}
+	const TSet<FBuffCount>& GetAllBuffs() const;
+	void GetAllBuffs(TArray<FBuffCount>& OutBuffs) const;
+
+	// Finds all buffs with "Tag" inside Identifying tags
+	UFUNCTION(BlueprintPure, Category = "AbilityComponent|Buffs")
+	void GetBuffsByTag(FGameplayTag Tag, TArray<FBuffCount>& OutBuffs, bool bExact = false) const;
+
+	// @return number of buffs with "Tag" inside Identifying tags
+	UFUNCTION(BlueprintPure, Category = "AbilityComponent|Buffs")
+	int32 CountBuffsByTag(FGameplayTag Tag, bool bExact = false) const;
 
 	UFUNCTION(BlueprintPure, Category = "AbilityComponent|Buffs")
 	int32 GetNumBuffs() const
@@ -365,24 +644,120 @@ public:
 		return Buffs.Num();
 	}
 
+	// @return a handle that stays valid while the buff is applied
+	UFUNCTION(BlueprintPure, Category = "AbilityComponent|Buffs")
+	FBuffHandle GetBuffHandle(const UBuff* Buff) const
+	{
+		return Buffs.MakeHandle(Buffs.Find(Buff));
+	}
+
+	// @return the buff of a handle or null if it was removed
+	UFUNCTION(BlueprintPure, Category = "AbilityComponent|Buffs")
+	UBuff* GetBuffFromHandle(FBuffHandle Handle) const;
+
+	UFUNCTION(BlueprintPure, Category = "AbilityComponent|Buffs")
+	int32 GetBuffCountFromHandle(FBuffHandle Handle) const;
+
+	const FBuffStore& GetBuffStore() const { return Buffs; }
+	const FReplicatedBuffList& GetReplicatedBuffs() const { return ReplicatedBuffs; }
+	const FReplicatedBuffList& GetOwnerReplicatedBuffs() const { return OwnerReplicatedBuffs; }
+
+	// @return how a buff replicates, resolving its Default policy
+	static EBuffReplicationMode GetBuffReplicationMode(const UBuff& Buff);
+
 protected:
 
+	// Called on server and clients after buffs changed
 	virtual void LocalOnBuffsChanged(const TSet<FBuffCount>& ModifiedBuffs, EBuffOperation Change);
 
+public:
+
+	// Pending coalesced events are broadcasted when disabled
+	void SetCoalesceBuffEvents(bool bEnabled);
+	bool IsCoalescingBuffEvents() const { return bCoalesceBuffEvents; }
+
 private:
 
 	void NotifyBuffsChanged(const TSet<FBuffCount>& ModifiedBuffs, EBuffOperation Change);
+	// Sends the current count and spec of a buff to the clients of its replication mode
+	void ReplicateBuff(const UBuff& Buff);
 
-	bool InternalApplyBuffs(const TSet<FBuffCount>& InBuffs, TSet<FBuffCount>& AppliedBuffs);
+	// @param Spec optionally applied to its buff if contained in InBuffs
+	bool InternalApplyBuffs(const TSet<FBuffCount>& InBuffs, TSet<FBuffCount>& AppliedBuffs, const FBuffSpec* Spec = nullptr);
 	bool InternalRemoveBuffs(const TSet<FBuffCount>& InBuffs, TSet<FBuffCount>& RemovedBuffs);
 
-	UFUNCTION(Client, Reliable)
-	void ClientOnBuffsChanged(const TArray<FBuffCount>& ModifiedBuffs, EBuffOperation Change);
-	UFUNCTION(NetMulticast, Reliable)
-	void MCOnBuffsChanged(const TArray<FBuffCount>& ModifiedBuffs, EBuffOperation Change);
+	// Updates local buffs on clients from a replicated buff count
+	void OnReplicatedBuffChanged(const FBuffSpec& Spec, int32 Count);
+	// Restarts the local lifetime of a buff refreshed on server
+	void OnReplicatedBuffRefreshed(UBuff* Buff);
+
+	// Removes predicted buffs and their counts
+	void RemovePredictedBuffs(TFunctionRef<bool(const FPredictedBuff&)> Predicate);
+
+	// Sets the count of a buff on clients without running its effects
+	void SetLocalBuffCount(const FBuffSpec& Spec, int32 Count);
+
+	// Broadcasts buff events coalesced during this frame
+	void FlushBuffEvents();
+
+	// Flushes deferred buff changes and events on next subsystem tick
+	void ScheduleBuffFlush();
+
+	// Starts or stops firing the period of an applied buff
+	void SetPeriodicBuff(const UBuff& Buff, bool bApplied);
+
+	// Accumulates buff changes to notify them on next flush
+	void DeferBuffsChanged(const TSet<FBuffCount>& ModifiedBuffs, EBuffOperation Change);
+	void FlushDeferredBuffs();
+	// Notifies deferred changes now. Called before other changes so that listeners receive them in order.
+	void NotifyDeferredBuffs();
 	/**End BUFFS */
 
 
+	/** BEGIN ATTRIBUTES */
+public:
+
+	// @return base value modified by all applied buffs
+	UFUNCTION(BlueprintPure, Category = "AbilityComponent|Attributes")
+	float GetAttributeValue(FGameplayTag Attribute) const;
+
+	UFUNCTION(BlueprintPure, Category = "AbilityComponent|Attributes")
+	float GetAttributeBaseValue(FGameplayTag Attribute) const;
+
+	// Base values are not replicated. Set them on server and clients.
+	UFUNCTION(BlueprintCallable, Category = "AbilityComponent|Attributes")
+	void SetAttributeBaseValue(FGameplayTag Attribute, float Value);
+
+	FAbilityAttributeSet& GetAttributes() { return Attributes; }
+	const FAbilityAttributeSet& GetAttributes() const { return Attributes; }
+	/** END ATTRIBUTES */
+
+
+	/** BEGIN SNAPSHOTS */
+public:
+
+	/** Captures equipped abilities, buffs with their lifetimes, cooldowns and tags into a versioned binary blob.
+	 * The blob can be stored in save games. Instigators of buffs and the state of abilities are not captured.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "AbilityComponent|Snapshots")
+	void CaptureSnapshot(TArray<uint8>& OutData) const;
+
+	/** Replaces the state of this component with a snapshot, like after respawning.
+	 * Only buffs that differ from the snapshot are applied or removed, and changes are notified once on
+	 * the next flush with their net counts.
+	 * Abilities and buffs are not loaded. Those not in memory are skipped, so load them before restoring.
+	 * @return false if the data is not a valid snapshot
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "AbilityComponent|Snapshots")
+	bool RestoreSnapshot(const TArray<uint8>& Data);
+
+private:
+
+	// Counts tags held by applied buffs while they are applied
+	void GetBuffTagGrants(TMap<FGameplayTag, int32>& OutGrants) const;
+	/** END SNAPSHOTS */
+
+
 	/** HELPERS */
 public:
 
@@ -458,6 +833,27 @@ public:
 	}
 };
 
+
+/**
+ * Coalesces tag changes done on a component while the scope lives.
+ * Listeners are notified once when the outermost scope ends. Scopes can be nested.
+ */
+struct FAbilityTagMutationScope
+{
+private:
+
+	UAbilitiesComponent* Component;
+
+public:
+
+	explicit FAbilityTagMutationScope(UAbilitiesComponent* InComponent);
+	~FAbilityTagMutationScope();
+
+	FAbilityTagMutationScope(const FAbilityTagMutationScope&) = delete;
+	FAbilityTagMutationScope& operator=(const FAbilityTagMutationScope&) = delete;
+};
+
+
 inline bool UAbilitiesComponent::HasAuthority() const
 {
 	if (!ensureMsgf(GetOwner(), TEXT("Owner must always be valid when calling HasAuthority.")))
@@ -469,11 +865,42 @@ inline bool UAbilitiesComponent::HasAuthority() const
 
 inline int32 UAbilitiesComponent::GetBuffCount(const UBuff* Buff) const
 {
-	if (const auto* BuffCount = Buffs.Find(Buff))
-	{
-		return BuffCount->Count;
-	}
-	return 0;
+	const int32 Slot = Buffs.Find(Buff);
+	return Slot != INDEX_NONE? Buffs.GetCount(Slot) : 0;
+}
+
+inline FBuffSpec UAbilitiesComponent::GetBuffSpec(const UBuff* Buff) const
+{
+	const int32 Slot = Buffs.Find(Buff);
+	// Buff assets are never modified through their specs
+	return Slot != INDEX_NONE? Buffs.GetSpec(Slot) : FBuffSpec{ const_cast<UBuff*>(Buff) };
+}
+
+inline float UAbilitiesComponent::GetAttributeValue(FGameplayTag Attribute) const
+{
+	return Attributes.GetValue(Attribute);
+}
+
+inline float UAbilitiesComponent::GetAttributeBaseValue(FGameplayTag Attribute) const
+{
+	return Attributes.GetBaseValue(Attribute);
+}
+
+inline void UAbilitiesComponent::SetAttributeBaseValue(FGameplayTag Attribute, float Value)
+{
+	Attributes.SetBaseValue(Attribute, Value);
+}
+
+inline UBuff* UAbilitiesComponent::GetBuffFromHandle(FBuffHandle Handle) const
+{
+	const int32 Slot = Buffs.Resolve(Handle);
+	return Slot != INDEX_NONE? Buffs.GetBuff(Slot) : nullptr;
+}
+
+inline int32 UAbilitiesComponent::GetBuffCountFromHandle(FBuffHandle Handle) const
+{
+	const int32 Slot = Buffs.Resolve(Handle);
+	return Slot != INDEX_NONE? Buffs.GetCount(Slot) : 0;
 }
 
 inline UAbility* UAbilitiesComponent::GetEquippedAbility(TSubclassOf<UAbility> Class) const
@@ -499,3 +926,20 @@ inline TSubclassOf<UAbility> UAbilitiesComponent::GetPressedAbilityFromInput(FNa
 	}
 	return {};
 }
+
+inline FAbilityTagMutationScope::FAbilityTagMutationScope(UAbilitiesComponent* InComponent)
+	: Component(InComponent)
+{
+	if (Component)
+	{
+		++Component->TagMutationDepth;
+	}
+}
+
+inline FAbilityTagMutationScope::~FAbilityTagMutationScope()
+{
+	if (Component && --Component->TagMutationDepth <= 0 && Component->bPendingTagsChanged)
+	{
+		Component->NotifyTagsChanged();
+	}
+}
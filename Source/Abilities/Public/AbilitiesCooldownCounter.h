@@ -3,11 +3,15 @@
 #pragma once
 
 #include <CoreMinimal.h>
-#include <Engine/EngineTypes.h>
 #include "Misc/SASOwnedStruct.h"
 #include "AbilitiesCooldownCounter.generated.h"
 
 
+/**
+ * Table of running cooldowns owned by an abilities component.
+ * Stored as parallel arrays sorted by end time, so the next cooldown to finish is always the first one
+ * and no world timers are needed.
+ */
 USTRUCT()
 struct ABILITIES_API FAbilitiesCooldownCounter : public FSASOwnedStruct
 {
@@ -15,8 +19,13 @@ struct ABILITIES_API FAbilitiesCooldownCounter : public FSASOwnedStruct
 
 protected:
 
+	// Ability class of each cooldown
 	UPROPERTY()
-	TMap<UClass*, FTimerHandle> Handles;
+	TArray<UClass*> Abilities;
+
+	// GameTime at which each cooldown finishes. Sorted from first to last.
+	UPROPERTY()
+	TArray<float> EndTimes;
 
 
 public:
@@ -32,10 +41,20 @@ public:
 	bool Reset(UClass* Ability);
 	void ResetAll();
 
-	bool IsCoolingDown(UClass* Ability) const { return Handles.Contains(Ability); }
+	bool IsCoolingDown(UClass* Ability) const { return Abilities.Contains(Ability); }
 	float GetRemaining(UClass* Ability) const;
 
+	// Abilities cooling down, from first to last to finish
+	const TArray<UClass*>& GetAbilities() const { return Abilities; }
+
+	// @return true if any cooldown is running
+	bool HasPending() const { return Abilities.Num() > 0; }
+
+	// Finishes all cooldowns that reached their end time
+	void Tick();
+
 private:
 
-	FTimerManager* GetTimerManager() const;
+	void RemoveAt(int32 Index);
+	void UpdateOwnerTick() const;
 };
@@ -0,0 +1,70 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <GameplayTagContainer.h>
+#include <UObject/SoftObjectPath.h>
+
+
+/**
+ * State of an abilities component stored as a compact versioned binary blob.
+ * Objects are stored by path and times as remaining seconds, so a snapshot can be restored in
+ * another world, like when loading a save game. See UAbilitiesComponent::CaptureSnapshot
+ * Each path or tag name is written once in a string table, and entries reference it by index.
+ */
+struct ABILITIES_API FAbilitiesSnapshot
+{
+	enum EVersion : int32
+	{
+		Initial = 1,
+		// Tag counts don't include tags held by buffs
+		TagsWithoutBuffs,
+		// Paths and tag names are written once in a string table and referenced by index
+		StringTable,
+		Latest = StringTable
+	};
+
+	struct FBuffEntry
+	{
+		FSoftObjectPath Buff;
+		int32 Count = 0;
+		float Magnitude = 1.f;
+		int32 Level = 1;
+		// Seconds until each stack, or the buff, expires. Empty without lifetime.
+		TArray<float> Lifetimes;
+	};
+
+	struct FCooldownEntry
+	{
+		FSoftClassPath Ability;
+		float Remaining = 0.f;
+	};
+
+	struct FTagEntry
+	{
+		FGameplayTag Tag;
+		int32 Count = 0;
+	};
+
+	TArray<FSoftClassPath> Abilities;
+	TArray<FBuffEntry> Buffs;
+	TArray<FCooldownEntry> Cooldowns;
+	TArray<FTagEntry> Tags;
+
+	// Read from a version where tag counts include the tags held by buffs
+	bool bTagCountsIncludeBuffs = false;
+
+
+	void Write(TArray<uint8>& OutData);
+
+	// @return false if the data is not a snapshot or has a newer version
+	bool Read(const TArray<uint8>& Data);
+
+private:
+
+	void Serialize(FArchive& Ar, int32 Version);
+
+	// Adds every path and tag name to a string table before writing
+	void GatherStrings(TArray<FString>& OutStrings, TMap<FString, int32>& OutIndices) const;
+};
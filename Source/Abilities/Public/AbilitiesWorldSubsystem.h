@@ -0,0 +1,115 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <Subsystems/WorldSubsystem.h>
+#include <Tickable.h>
+
+#include "AbilitiesWorldSubsystem.generated.h"
+
+
+class UAbilitiesComponent;
+class UBuff;
+
+
+// Applied buffs sharing the same period, fired on the same pass
+struct FBuffPeriodBucket
+{
+	float Period = 0.f;
+	// Earliest next time of its entries
+	float NextTime = 0.f;
+
+	// Entries by index. Removed entries are null until compacted.
+	TArray<TWeakObjectPtr<UAbilitiesComponent>> Components;
+	TArray<TWeakObjectPtr<const UBuff>> Buffs;
+	// Each entry fires a period after it was applied
+	TArray<float> NextTimes;
+
+	TMap<TPair<const UAbilitiesComponent*, const UBuff*>, int32> Indices;
+
+	bool bHasPendingRemovals = false;
+};
+
+
+/**
+ * Ticks all abilities components of a world from a single tick function.
+ * Components only register while they have something to update (ticking abilities, buff lifetimes...),
+ * so idle components cost nothing per frame.
+ * Also flushes deferred buff notifications once per frame, and fires periodic buffs grouped by their period.
+ */
+UCLASS()
+class ABILITIES_API UAbilitiesWorldSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+protected:
+
+	// Dense list of components to tick. Each component caches its own index.
+	UPROPERTY(Transient)
+	TArray<UAbilitiesComponent*> Components;
+
+	// Components with deferred buff notifications
+	TArray<TWeakObjectPtr<UAbilitiesComponent>> PendingBuffFlushes;
+
+	// Applied periodic buffs grouped by their period
+	TArray<FBuffPeriodBucket> PeriodBuckets;
+	int32 NumPeriodicBuffs = 0;
+
+private:
+
+	bool bIsTicking = false;
+	bool bHasPendingRemovals = false;
+
+
+public:
+
+	// Shorter periods are clamped to it
+	static constexpr float MinBuffPeriod = 0.01f;
+	// Periods fired per buff on a single tick. Further missed periods are skipped.
+	static constexpr int32 MaxPeriodsPerTick = 8;
+
+
+	/** Begin USubsystem */
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+	/** End USubsystem */
+
+	void Register(UAbilitiesComponent& Component);
+	void Unregister(UAbilitiesComponent& Component);
+
+	int32 GetNumRegistered() const { return Components.Num(); }
+
+	// Flushes deferred buff notifications of a component on next tick
+	void AddPendingBuffFlush(UAbilitiesComponent& Component);
+
+	/**
+	 * Fires UBuff::OnPeriod of an applied buff until removed.
+	 * The first call happens one period after the buff is applied.
+	 */
+	void AddPeriodicBuff(UAbilitiesComponent& Component, const UBuff& Buff);
+	void RemovePeriodicBuff(UAbilitiesComponent& Component, const UBuff& Buff);
+
+	int32 GetNumPeriodicBuffs() const { return NumPeriodicBuffs; }
+
+	/** Begin FTickableGameObject */
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override
+	{
+		return Components.Num() > 0 || PendingBuffFlushes.Num() > 0 || NumPeriodicBuffs > 0;
+	}
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	/** End FTickableGameObject */
+
+private:
+
+	void CompactComponents();
+	void FlushBuffs();
+	void TickPeriodicBuffs();
+	void FireBucket(int32 BucketIndex, float GameTime);
+	void CompactBucket(FBuffPeriodBucket& Bucket);
+
+	static float GetBuffPeriod(const UBuff& Buff);
+};
@@ -10,6 +10,7 @@
 #include "AbilitiesModule.h"
 #include "AbilityTypes.h"
 #include "AbilityBase.h"
+#include "AbilityTagMask.h"
 #include "Ability.generated.h"
 
 
@@ -184,6 +185,17 @@ protected:
 	UPROPERTY(Transient)
 	FName PressedEvent;
 
+private:
+
+	// True while registered on the component to be interrupted by InterruptWithTags
+	bool bListensToInterrupts = false;
+
+	// Index in the availability cache of the component
+	int32 AvailabilitySlot = INDEX_NONE;
+
+	// RequiredTags and RequiredToNotHaveTags compiled into masks. Only used on the class default object.
+	FAbilityTagRequirements TagRequirements;
+
 
 	/************************************************************************/
 	/* METHODS                                                              */
@@ -196,6 +208,10 @@ protected:
 	virtual void OnStateChanged(FAbilityStateTransition Transition, const FStructContainer& Container) override;
 	virtual void EndPlay() override;
 
+public:
+
+	virtual EAbilityBlueprintEvent FindBlueprintEvents() const override;
+
 
 	/** BEGIN Cast */
 public:
@@ -293,7 +309,13 @@ private:
 	UFUNCTION(NetMulticast, Reliable)
 	void MCResetCooldown();
 
-	void LocalStartCooldown();
+	// Replaces the cooldown with the remaining seconds of a snapshot. See UAbilitiesComponent::RestoreSnapshot
+	void RestoreCooldown(float Remaining);
+	UFUNCTION(NetMulticast, Reliable)
+	void MCRestoreCooldown(float Remaining);
+
+	void LocalStartCooldown() { LocalStartCooldown(CooldownDuration); }
+	void LocalStartCooldown(float Duration);
 	void LocalResetCooldown();
 
 	void NotifyCooldownReady(ECooldownReadyReason Reason);
@@ -305,6 +327,12 @@ public:
 
 	virtual void OnTagsChanged(const FGameplayTagContainer& Tags);
 
+	// Called before OnTagsChanged with only the tags added and removed
+	virtual void OnTagsDelta(const FAbilityTagsDelta& Delta) {}
+
+	// @return tag requirements of this ability class, compiled on first use if not compiled at load
+	const FAbilityTagRequirements& GetTagRequirements() const;
+
 	UFUNCTION(BlueprintImplementableEvent, meta = (DisplayName="On Tags Changed"))
 	void EventOnTagsChanged(const FGameplayTagContainer& Tags);
 	/** END Tags */
@@ -411,9 +439,11 @@ public:
 	virtual bool ReplicateSubobjects(class UActorChannel *Channel, class FOutBunch *Bunch, FReplicationFlags *RepFlags) { return false; }
 
 	virtual void PreDestroyFromReplication() override;
+	virtual void PostLoad() override;
 
 #if WITH_EDITOR
 	virtual bool CanEditChange(const FProperty* InProperty) const override;
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
 #endif //WITH_EDITOR
 	/** END UObject */
 };
@@ -467,6 +497,14 @@ inline void UAbility::ResetCooldown()
 	}
 }
 
+inline void UAbility::RestoreCooldown(float Remaining)
+{
+	if(HasAuthority())
+	{
+		MCRestoreCooldown(Remaining);
+	}
+}
+
 inline bool UAbility::IsRunning() const
 {
 	return HasBegunPlay() &&
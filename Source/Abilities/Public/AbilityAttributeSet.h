@@ -0,0 +1,123 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <GameplayTagContainer.h>
+
+#include "AbilityAttributeSet.generated.h"
+
+
+class UBuff;
+
+
+UENUM(BlueprintType)
+enum class EAttributeModifierOp : uint8
+{
+	// Adds Magnitude per stack to the base value
+	Additive,
+	// Multiplies by Magnitude per stack after additive modifiers
+	Multiplicative,
+	// Replaces the final value. The last override applied wins.
+	Override
+};
+
+USTRUCT(BlueprintType)
+struct FAttributeModifier
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Attribute)
+	FGameplayTag Attribute;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Attribute)
+	EAttributeModifierOp Operation = EAttributeModifierOp::Additive;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Attribute)
+	float Magnitude = 0.f;
+};
+
+
+/**
+ * Numeric attributes of a component identified by tags, modified by buffs.
+ * Final values are (Base + Additive) * Multiplicative, unless overridden.
+ * Values are cached and only attributes touched by modifier changes are aggregated again when read.
+ */
+struct ABILITIES_API FAbilityAttributeSet
+{
+private:
+
+	/** Attributes, by attribute index */
+	TArray<FGameplayTag> Attributes;
+	TArray<float> BaseValues;
+	mutable TArray<float> Values;
+	mutable TBitArray<> Dirty;
+	mutable bool bAnyDirty = false;
+
+	TMap<FGameplayTag, int32> Indices;
+
+	/** Modifiers in order of application. Magnitudes already include stacks. */
+	TArray<const UBuff*> ModifierSources;
+	TArray<int32> ModifierAttributes;
+	TArray<EAttributeModifierOp> ModifierOps;
+	TArray<float> ModifierMagnitudes;
+
+	/** Aggregation scratch, by attribute index */
+	mutable TArray<float> Additives;
+	mutable TArray<float> Multipliers;
+	mutable TArray<float> Overrides;
+	mutable TArray<uint8> Overridden;
+
+
+public:
+
+	int32 FindIndex(const FGameplayTag& Attribute) const
+	{
+		const int32* Index = Indices.Find(Attribute);
+		return Index? *Index : INDEX_NONE;
+	}
+
+	int32 FindOrAddIndex(const FGameplayTag& Attribute);
+
+	bool Contains(const FGameplayTag& Attribute) const { return Indices.Contains(Attribute); }
+
+	int32 Num() const { return Attributes.Num(); }
+
+	void SetBaseValue(const FGameplayTag& Attribute, float Value);
+	float GetBaseValue(const FGameplayTag& Attribute) const;
+
+	// @return final value of an attribute, or 0 if it doesn't exist
+	float GetValue(const FGameplayTag& Attribute) const;
+
+	/**
+	 * Replaces all modifiers of a buff.
+	 * If only stacks or scale changed, modifiers are updated in place and keep their application order.
+	 * @param Count of stacks. Modifiers are removed if 0.
+	 * @param Scale of additive and multiplicative magnitudes, usually the magnitude of a FBuffSpec
+	 */
+	void SetModifiers(const UBuff* Source, TArrayView<const FAttributeModifier> Modifiers, int32 Count, float Scale = 1.f);
+
+	void RemoveModifiers(const UBuff* Source) { SetModifiers(Source, {}, 0); }
+
+	void Empty();
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+
+	void MarkDirty(int32 Index) const
+	{
+		Dirty[Index] = true;
+		bAnyDirty = true;
+	}
+
+	// Updates magnitudes of modifiers already applied by a buff
+	// @return false if modifiers don't match the ones applied before
+	bool UpdateModifiers(TArrayView<const int32> OldModifiers, TArrayView<const FAttributeModifier> Modifiers, int32 Count, float Scale);
+
+	// @return magnitude of a modifier including stacks and scale
+	static float GetMagnitude(const FAttributeModifier& Modifier, int32 Count, float Scale);
+
+	// Aggregates all modifiers of dirty attributes
+	void Update() const;
+};
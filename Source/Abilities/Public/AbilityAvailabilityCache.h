@@ -0,0 +1,47 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+
+
+/**
+ * Cached results of CanCast and CanActivate with an empty container, one bit per ability slot.
+ * Slots are only re-evaluated after being invalidated.
+ */
+struct FAbilityAvailabilityCache
+{
+	TBitArray<> Dirty;
+	TBitArray<> Castable;
+	TBitArray<> Activatable;
+
+
+	int32 Num() const { return Dirty.Num(); }
+
+	void Reset(int32 NumSlots)
+	{
+		Dirty.Init(true, NumSlots);
+		Castable.Init(false, NumSlots);
+		Activatable.Init(false, NumSlots);
+	}
+
+	void InvalidateAll()
+	{
+		Dirty.Init(true, Dirty.Num());
+	}
+
+	void Invalidate(int32 Slot)
+	{
+		if (Dirty.IsValidIndex(Slot))
+		{
+			Dirty[Slot] = true;
+		}
+	}
+
+	void Set(int32 Slot, bool bCastable, bool bActivatable)
+	{
+		Dirty[Slot] = false;
+		Castable[Slot] = bCastable;
+		Activatable[Slot] = bActivatable;
+	}
+};
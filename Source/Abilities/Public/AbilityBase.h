@@ -6,6 +6,7 @@
 #include <Engine/World.h>
 
 #include "AbilityTypes.h"
+#include "Buff.h"
 #include "Misc/StructContainer.h"
 #include "AbilityBase.generated.h"
 
@@ -51,6 +52,13 @@ private:
 	UPROPERTY(ReplicatedUsing = "OnRep_Owner")
 	UAbilitiesComponent* Owner;
 
+	// Request of the state change being applied. Keys buffs predicted during it.
+	uint32 PredictionRequestId = 0;
+
+	// Events implemented in Blueprint by this class. Only used on the CDO.
+	EAbilityBlueprintEvent BlueprintEvents = EAbilityBlueprintEvent::None;
+	bool bBlueprintEventsCached = false;
+
 
 	UFUNCTION()
 	void OnRep_Owner();
@@ -109,6 +117,16 @@ protected:
 
 	bool TrySetLocalState(FAbilityStateTransition Transition, const FStructContainer& Container);
 
+	/** Applies a buff predicted by the owning client during a state change, like OnActivate.
+	 * Must run on both client and server. The client applies it locally, and reverts it if the server rejects the state.
+	 * Outside of predicted state changes, only the server applies it.
+	 */
+	UFUNCTION(BlueprintCallable, Category = Ability)
+	bool ApplyPredictedBuff(const FBuffSpec& Spec, int32 Count = 1);
+
+	// @return true if the ability can do a transition from its current state. Doesn't change the state.
+	bool CanTransition(FAbilityStateTransition Transition, const FStructContainer& Container);
+
 	virtual bool CheckTransition(FAbilityStateTransition Transition, const FStructContainer& Container);
 
 	virtual void OnStateChanged(FAbilityStateTransition Transition, const FStructContainer& Container) {}
@@ -123,13 +141,23 @@ protected:
 	UFUNCTION(BlueprintImplementableEvent, Category = Ability, meta = (DisplayName = "Pre-State Change"))
 	bool EventPreStateChange(FAbilityStateTransition Transition);
 
+public:
+
+	// @return true if this class implements an event in Blueprint. Found once per class.
+	bool IsBlueprintEventImplemented(EAbilityBlueprintEvent Event) const;
+
+	virtual EAbilityBlueprintEvent FindBlueprintEvents() const;
+
 private:
 
 	void DoBeginPlay(UAbilitiesComponent* InOwner);
 	void DoTick(float DeltaTime)
 	{
 		Tick(DeltaTime);
-		EventTick(DeltaTime);
+		if (IsBlueprintEventImplemented(EAbilityBlueprintEvent::Tick))
+		{
+			EventTick(DeltaTime);
+		}
 	}
 	void DoEndPlay();
 
@@ -186,7 +214,10 @@ inline bool UAbilityBase::CheckTransition(FAbilityStateTransition Transition, co
 inline void UAbilityBase::DoPreStateChange(FAbilityStateTransition Transition)
 {
 	PreStateChange(Transition);
-	EventPreStateChange(Transition);
+	if (IsBlueprintEventImplemented(EAbilityBlueprintEvent::PreStateChange))
+	{
+		EventPreStateChange(Transition);
+	}
 }
 
 inline bool UAbilityBase::HasBegunPlay() const
@@ -0,0 +1,47 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <GameplayTagContainer.h>
+
+#include "AbilityTagMask.h"
+
+
+/**
+ * Counts how many times each tag has been granted, so that overlapping grants (e.g. two buffs adding the same tag)
+ * don't remove each other's tags when reverted.
+ * Counts are indexed by FAbilityTagIndex, so grants and revokes are O(1).
+ * Granted tags are mirrored into a mask for fast requirement checks.
+ */
+struct ABILITIES_API FAbilityTagCounter
+{
+private:
+
+	// Grants of each tag by its FAbilityTagIndex
+	TArray<int16> Counts;
+
+	// Tags with one or more grants
+	FAbilityTagMask Mask;
+
+
+public:
+
+	// Adds one grant of a tag
+	// @return true if the tag was not granted before
+	bool Grant(const FGameplayTag& Tag);
+
+	// Removes one grant of a tag
+	// @return true if the tag was granted and it is not anymore
+	bool Revoke(const FGameplayTag& Tag);
+
+	int32 GetCount(const FGameplayTag& Tag) const;
+
+	const FAbilityTagMask& GetMask() const { return Mask; }
+
+	// Clears all counts, then grants once each explicit tag of a container
+	void Reset(const FGameplayTagContainer& ExplicitTags);
+
+	// Grants once each explicit tag of a container that has no grants. Counts of granted tags are kept.
+	void GrantMissing(const FGameplayTagContainer& ExplicitTags);
+};
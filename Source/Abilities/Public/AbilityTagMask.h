@@ -0,0 +1,128 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <GameplayTagContainer.h>
+
+
+/**
+ * Project-wide dense index of gameplay tags.
+ * Tags receive an index the first time they are used. Indices are never released, so masks built from them
+ * stay valid for the whole session.
+ */
+class ABILITIES_API FAbilityTagIndex
+{
+	TMap<FGameplayTag, int32> Indices;
+
+public:
+
+	static FAbilityTagIndex& Get();
+
+	int32 FindOrAddIndex(const FGameplayTag& Tag);
+
+	// @return index of a tag or INDEX_NONE if it was never used
+	int32 FindIndex(const FGameplayTag& Tag) const;
+
+	int32 Num() const { return Indices.Num(); }
+};
+
+
+/**
+ * Bitset of exact tags indexed by FAbilityTagIndex.
+ * The first 256 tags are stored inline.
+ */
+struct ABILITIES_API FAbilityTagMask
+{
+private:
+
+	static constexpr int32 BitsPerWord = 64;
+
+	TArray<uint64, TInlineAllocator<4>> Words;
+
+
+public:
+
+	FAbilityTagMask() = default;
+
+	// Builds a mask from the explicit tags of a container
+	explicit FAbilityTagMask(const FGameplayTagContainer& Tags);
+
+	void Set(int32 Index)
+	{
+		const int32 Word = Index / BitsPerWord;
+		if (Word >= Words.Num())
+		{
+			Words.SetNumZeroed(Word + 1);
+		}
+		Words[Word] |= uint64(1) << (Index % BitsPerWord);
+	}
+
+	void Clear(int32 Index)
+	{
+		const int32 Word = Index / BitsPerWord;
+		if (Word < Words.Num())
+		{
+			Words[Word] &= ~(uint64(1) << (Index % BitsPerWord));
+		}
+	}
+
+	bool IsSet(int32 Index) const
+	{
+		const int32 Word = Index / BitsPerWord;
+		return Word < Words.Num() && (Words[Word] & (uint64(1) << (Index % BitsPerWord))) != 0;
+	}
+
+	// @return true if all bits of Other are set. Same as HasAllExact.
+	bool HasAll(const FAbilityTagMask& Other) const
+	{
+		const int32 NumWords = Words.Num();
+		for (int32 I = 0; I < Other.Words.Num(); ++I)
+		{
+			const uint64 Word = I < NumWords? Words[I] : 0;
+			if ((Other.Words[I] & ~Word) != 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// @return true if any bit of Other is set. Same as HasAnyExact.
+	bool HasAny(const FAbilityTagMask& Other) const
+	{
+		const int32 NumWords = FMath::Min(Words.Num(), Other.Words.Num());
+		for (int32 I = 0; I < NumWords; ++I)
+		{
+			if ((Words[I] & Other.Words[I]) != 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void Reset() { Words.Reset(); }
+};
+
+
+// Required and blocked tags of an ability class compiled into masks
+struct ABILITIES_API FAbilityTagRequirements
+{
+	FAbilityTagMask Required;
+	FAbilityTagMask Blocked;
+	bool bCompiled = false;
+
+
+	void Compile(const FGameplayTagContainer& RequiredTags, const FGameplayTagContainer& BlockedTags)
+	{
+		Required = FAbilityTagMask{ RequiredTags };
+		Blocked = FAbilityTagMask{ BlockedTags };
+		bCompiled = true;
+	}
+
+	bool Check(const FAbilityTagMask& Tags) const
+	{
+		return Tags.HasAll(Required) && !Tags.HasAny(Blocked);
+	}
+};
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <CoreMinimal.h>
+#include <GameplayTagContainer.h>
 
 #include "AbilityTypes.generated.h"
 
@@ -31,6 +32,26 @@ enum class EAbilityTransitionFlag : uint8
 ENUM_CLASS_FLAGS(EAbilityTransitionFlag);
 
 
+// Ability events that may be implemented in Blueprint. Events that are not call Event*_Implementation directly,
+// skipping the Blueprint VM but not native overrides.
+enum class EAbilityBlueprintEvent : uint32
+{
+	None            = 0,
+	Tick            = 1 << 0,
+	PreStateChange  = 1 << 1,
+	CanCast         = 1 << 2,
+	Cast            = 1 << 3,
+	CastFinish      = 1 << 4,
+	CanActivate     = 1 << 5,
+	Activate        = 1 << 6,
+	Deactivate      = 1 << 7,
+	CooldownStarted = 1 << 8,
+	CooldownReady   = 1 << 9,
+	TagsChanged     = 1 << 10
+};
+ENUM_CLASS_FLAGS(EAbilityBlueprintEvent);
+
+
 USTRUCT(BlueprintType)
 struct FAbilityStateTransition
 {
@@ -73,6 +94,47 @@ struct TStructOpsTypeTraits<FAbilityStateTransition> : TStructOpsTypeTraitsBase2
 	enum { WithNetSerializer = true };
 };
 
+
+// Tags added and removed by a single (possibly coalesced) tag change
+struct FAbilityTagsDelta
+{
+	FGameplayTagContainer Added;
+	FGameplayTagContainer Removed;
+
+
+	// Records a tag that was not present before
+	void Add(const FGameplayTag& Tag)
+	{
+		// Removing and adding back the same tag is not a change
+		if (!Removed.RemoveTag(Tag))
+		{
+			Added.AddTag(Tag);
+		}
+	}
+
+	// Records a tag that was present before
+	void Remove(const FGameplayTag& Tag)
+	{
+		// Adding and removing the same tag is not a change
+		if (!Added.RemoveTag(Tag))
+		{
+			Removed.AddTag(Tag);
+		}
+	}
+
+	bool IsEmpty() const
+	{
+		return Added.Num() <= 0 && Removed.Num() <= 0;
+	}
+
+	void Reset()
+	{
+		Added.Reset();
+		Removed.Reset();
+	}
+};
+
+
 inline void FAbilityStateTransition::Swap()
 {
 	::Swap(Origin, Destination);
@@ -7,10 +7,13 @@
 #include <GameplayTagContainer.h>
 #include <Engine/Texture2D.h>
 
+#include "AbilityAttributeSet.h"
 #include "Buff.generated.h"
 
 
+class AActor;
 class UAbilitiesComponent;
+class UAbilityBase;
 class UBuff;
 
 
@@ -40,6 +43,120 @@ struct FBuffCount
 };
 
 
+// A buff asset with the runtime parameters it is applied with. Stored inline by components, so applying
+// a parameterised buff doesn't need a new buff object.
+USTRUCT(BlueprintType)
+struct FBuffSpec
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Buff)
+	UBuff* Buff = nullptr;
+
+	// Scales attribute modifiers of the buff. Free to use by buff effects.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Buff)
+	float Magnitude = 1.f;
+
+	// Actor that applied the buff. Not replicated.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Buff)
+	AActor* Instigator = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Buff)
+	int32 Level = 1;
+
+
+	FBuffSpec() {}
+	FBuffSpec(UBuff* Buff) : Buff(Buff) {}
+	FBuffSpec(UBuff* Buff, float Magnitude, AActor* Instigator = nullptr, int32 Level = 1)
+		: Buff(Buff), Magnitude(Magnitude), Instigator(Instigator), Level(Level)
+	{}
+};
+
+
+// Identifies buffs predicted by an ability state change request. See UAbilityBase::ApplyPredictedBuff
+USTRUCT()
+struct FBuffPredictionKey
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	UAbilityBase* Ability = nullptr;
+
+	UPROPERTY()
+	uint32 RequestId = 0;
+
+
+	FBuffPredictionKey() {}
+	FBuffPredictionKey(UAbilityBase* Ability, uint32 RequestId) : Ability(Ability), RequestId(RequestId) {}
+
+	bool IsValid() const { return Ability && RequestId > 0; }
+
+	// Requests of an ability are ordered, so a key confirms all previous ones
+	bool Confirms(const FBuffPredictionKey& Other) const
+	{
+		return Ability == Other.Ability && Other.RequestId <= RequestId;
+	}
+};
+
+
+// Which machines receive a buff. See UAbilitiesComponent::BuffReplication
+UENUM(BlueprintType)
+enum class EBuffReplicationPolicy : uint8
+{
+	// Uses UAbilitiesComponent::BuffReplication
+	Default,
+	OnlyServer,
+	OwningClient,
+	AllClients
+};
+
+
+// How a buff resolves a conflict with the applied buff of its stacking group
+UENUM(BlueprintType)
+enum class EBuffStackingPolicy : uint8
+{
+	// Not applied while another buff of the group is
+	Reject,
+	// Removes the applied buff of the group
+	Replace,
+	// Replaces the applied buff of the group if its magnitude is higher.
+	// Applied again with a lower magnitude, it keeps its spec.
+	KeepHighestMagnitude,
+	// Not applied, but restarts the lifetime of all stacks of the applied buff of the group.
+	// Applied again, it also restarts the lifetime of its previous stacks.
+	RefreshDuration
+};
+
+
+// Net tag grants and revokes of applying or reverting a buff, merged from all its tag containers
+struct ABILITIES_API FBuffTagChanges
+{
+	// Tags granted, repeated if granted more than once
+	TArray<FGameplayTag, TInlineAllocator<4>> Grants;
+	// Tags revoked, repeated if revoked more than once
+	TArray<FGameplayTag, TInlineAllocator<4>> Revokes;
+
+
+	// Tags both added and removed cancel each other
+	void Compile(TArrayView<const FGameplayTagContainer* const> Added, TArrayView<const FGameplayTagContainer* const> Removed);
+
+	bool IsEmpty() const { return Grants.Num() <= 0 && Revokes.Num() <= 0; }
+};
+
+
+// Buff events that may be implemented in Blueprint. Events that are not call Event*_Implementation directly,
+// skipping the Blueprint VM but not native overrides.
+enum class EBuffBlueprintEvent : uint8
+{
+	None            = 0,
+	ApplyEffects    = 1 << 0,
+	RevertEffects   = 1 << 1,
+	ApplyStackDelta = 1 << 2,
+	Period          = 1 << 3
+};
+ENUM_CLASS_FLAGS(EBuffBlueprintEvent);
+
+
 UCLASS(BlueprintType, Blueprintable, Abstract)
 class ABILITIES_API UBuff : public UDataAsset
 {
@@ -77,9 +194,13 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, AdvancedDisplay, Category = Effects)
 	FGameplayTagContainer RemoveTagsOnRevert;
 
+	// Attributes modified while applied. Scaled by the count of stacks.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Effects)
+	TArray<FAttributeModifier> Modifiers;
+
 
 	/** If true, more than one of the same buff can be applied
-	 * When a second stackable buff is applied, the previous amount is reverted, then the new count (previous + 1) is applied
+	 * When a second stackable buff is applied, "Apply Stack Delta" is called with the previous and new counts
 	 */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Buff)
 	bool bStackable = false;
@@ -92,6 +213,14 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Buff, meta=(EditCondition="bUnique"))
 	bool bReplacePreviousUnique = false;
 
+	// Only one buff of a group is applied at the same time. Stacks of the same buff are not a conflict.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Buff)
+	FGameplayTag StackingGroup;
+
+	// How this buff resolves a conflict with the applied buff of its group
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Buff)
+	EBuffStackingPolicy StackingPolicy = EBuffStackingPolicy::Reject;
+
 	// If true, the buff will be removed after "LifetimeDuration" seconds.
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Buff, meta = (InlineEditConditionToggle))
 	bool bHasLifetime = false;
@@ -100,29 +229,89 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Buff, meta = (ClampMin = 0, EditCondition = "bHasLifetime", ForceUnits = s))
 	float LifetimeDuration = 1.f;
 
+	// If true, when stackable, each stack expires "LifetimeDuration" seconds after it was applied
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Buff)
+	bool bPerStackLifetime = false;
+
+	// Seconds between "On Period" calls while applied. 0 disables it.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Buff, meta = (ClampMin = 0, ForceUnits = s))
+	float Period = 0.f;
+
 	// Tags used to identify this buff. They wont be applied or reverted.
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Buff)
 	FGameplayTagContainer Tags;
 
+	// Which clients receive this buff. Cosmetic buffs may need all clients while stats may only need the owner.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Buff)
+	EBuffReplicationPolicy Replication = EBuffReplicationPolicy::Default;
+
+private:
+
+	// Events implemented in Blueprint by this class. Only used on the CDO.
+	EBuffBlueprintEvent BlueprintEvents = EBuffBlueprintEvent::None;
+	bool bBlueprintEventsCached = false;
+
+	// Tag containers merged on load, so that applying or reverting changes tags once
+	mutable FBuffTagChanges ApplyTagChanges;
+	mutable FBuffTagChanges RevertTagChanges;
+	mutable bool bTagChangesCompiled = false;
+
+	// Spec of the effects being applied or reverted. Read by Event*_Implementation, which has no spec parameter.
+	mutable const FBuffSpec* EffectSpec = nullptr;
+
 
 	/************************************************************************/
 	/* METHODS                                                              */
 	/************************************************************************/
 public:
 
+	virtual void PostLoad() override;
+
+	// @return true if this class implements an event in Blueprint. Found once per class.
+	bool IsBlueprintEventImplemented(EBuffBlueprintEvent Event) const;
+
+	virtual EBuffBlueprintEvent FindBlueprintEvents() const;
+
 #if WITH_EDITOR
 	virtual bool CanEditChange(const FProperty* InProperty) const override;
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
 #endif
 
 	// Called from the asset object. Buffs don't get instanced in runtime.
-	void DoApplyEffects(UAbilitiesComponent* Component, int32 Count) const;
-	void DoRevertEffects(UAbilitiesComponent* Component, int32 Count) const;
+	void DoApplyEffects(UAbilitiesComponent* Component, const FBuffSpec& Spec, int32 Count) const;
+	void DoRevertEffects(UAbilitiesComponent* Component, const FBuffSpec& Spec, int32 Count) const;
+	// Called when an applied buff only changes its count. Tags are not touched.
+	void DoApplyStackDelta(UAbilitiesComponent* Component, const FBuffSpec& Spec, int32 OldCount, int32 NewCount) const;
+	// Called every Period seconds while applied
+	void DoPeriod(UAbilitiesComponent* Component, int32 Count) const;
 
 protected:
 
 	virtual void ApplyEffects(UAbilitiesComponent* Component, int32 Count) const {}
 	virtual void RevertEffects(UAbilitiesComponent* Component, int32 Count) const {}
 
+	// Receive the spec the buff was applied with. By default call ApplyEffects and RevertEffects.
+	virtual void ApplySpecEffects(UAbilitiesComponent* Component, const FBuffSpec& Spec, int32 Count) const
+	{
+		ApplyEffects(Component, Count);
+	}
+	virtual void RevertSpecEffects(UAbilitiesComponent* Component, const FBuffSpec& Spec, int32 Count) const
+	{
+		RevertEffects(Component, Count);
+	}
+
+	// By default reverts the effects of the old count and applies the new one
+	virtual void ApplyStackDelta(UAbilitiesComponent* Component, int32 OldCount, int32 NewCount) const;
+
+	virtual void OnPeriod(UAbilitiesComponent* Component, int32 Count) const {}
+
+	// Merges tag containers if not done on load
+	void CompileTagChanges() const;
+
+	// Call Blueprint events only if implemented, else their native versions
+	void CallApplyEffects(UAbilitiesComponent* Component, const FBuffSpec& Spec, int32 Count) const;
+	void CallRevertEffects(UAbilitiesComponent* Component, const FBuffSpec& Spec, int32 Count) const;
+
 	/**
 	 * Called when a buff is applied.
 	 * @param Component that has the buff
@@ -139,6 +328,26 @@ protected:
 	UFUNCTION(BlueprintNativeEvent, Category = Buff, meta = (DisplayName = "Revert Effects"))
 	void EventRevertEffects(UAbilitiesComponent* Component, int32 Count) const;
 
+	/**
+	 * Called when a stackable buff gains or loses stacks.
+	 * By default calls "Revert Effects" with the old count and "Apply Effects" with the new one.
+	 * Buffs that only apply tags can leave it empty.
+	 * @param Component that has the buff
+	 * @param OldCount of buffs applied before
+	 * @param NewCount of buffs applied now
+	 */
+	UFUNCTION(BlueprintNativeEvent, Category = Buff, meta = (DisplayName = "Apply Stack Delta"))
+	void EventApplyStackDelta(UAbilitiesComponent* Component, int32 OldCount, int32 NewCount) const;
+
+	/**
+	 * Called every "Period" seconds while the buff is applied. Only on server.
+	 * Buffs with the same period are called together, so the first call can happen earlier than a full period.
+	 * @param Component that has the buff
+	 * @param Count of buffs applied (if stackable)
+	 */
+	UFUNCTION(BlueprintNativeEvent, Category = Buff, meta = (DisplayName = "On Period"))
+	void EventOnPeriod(UAbilitiesComponent* Component, int32 Count) const;
+
 public:
 
 	UFUNCTION(BlueprintPure, Category = Buff)
@@ -148,16 +357,30 @@ public:
 	UFUNCTION(BlueprintPure, Category = Buff)
 	float GetLifetimeDuration() const
 	{
-		return (bHasLifetime && !bStackable)? FMath::Max(LifetimeDuration, 0.f) : 0.f;
+		return (bHasLifetime && (!bStackable || bPerStackLifetime))? FMath::Max(LifetimeDuration, 0.f) : 0.f;
 	}
 
+	float GetPeriod() const { return FMath::Max(Period, 0.f); }
+
+	// @return true if each stack expires on its own
+	bool HasPerStackLifetime() const { return bStackable && bPerStackLifetime && GetLifetimeDuration() > 0.f; }
+
 	bool IsUnique() const { return bUnique; }
 	bool ReplacesPreviousUnique() const { return bReplacePreviousUnique; }
 
+	const FGameplayTag& GetStackingGroup() const { return StackingGroup; }
+	EBuffStackingPolicy GetStackingPolicy() const { return StackingPolicy; }
+
 	bool IsStackable() const { return bStackable; }
 
+	EBuffReplicationPolicy GetReplication() const { return Replication; }
+
 	const FGameplayTagContainer& GetTags() const { return Tags; }
 
+	const FGameplayTagContainer& GetTagsToApply() const { return TagsToApply; }
+
+	const TArray<FAttributeModifier>& GetModifiers() const { return Modifiers; }
+
 };
 
 inline FText UBuff::GetDisplayName() const
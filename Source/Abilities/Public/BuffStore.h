@@ -0,0 +1,239 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <GameFramework/Actor.h>
+#include <GameplayTagContainer.h>
+
+#include "Buff.h"
+#include "BuffStore.generated.h"
+
+
+/**
+ * Stable reference to a buff applied on a component.
+ * Becomes invalid when the buff is removed, even if its slot is reused.
+ */
+USTRUCT(BlueprintType)
+struct FBuffHandle
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Index = INDEX_NONE;
+
+	UPROPERTY()
+	int32 Generation = 0;
+
+
+	FBuffHandle() {}
+	FBuffHandle(int32 Index, int32 Generation) : Index(Index), Generation(Generation) {}
+
+	bool IsSet() const { return Index != INDEX_NONE; }
+
+	bool operator==(const FBuffHandle& Other) const
+	{
+		return Index == Other.Index && Generation == Other.Generation;
+	}
+};
+
+
+/**
+ * Buffs applied on a component stored as dense parallel arrays indexed by slot.
+ * Buffs are found by an open-addressed index and classes by a small table, so queries don't hash containers.
+ * Removed slots are reused by the next buff.
+ */
+USTRUCT()
+struct ABILITIES_API FBuffStore
+{
+	GENERATED_BODY()
+
+private:
+
+	using FSlotList = TArray<int32, TInlineAllocator<2>>;
+
+	// Buff of each slot. Null if the slot is free.
+	UPROPERTY()
+	TArray<UBuff*> Buffs;
+
+	// Stacks of each slot
+	TArray<int32> Counts;
+
+	// Spec parameters of each slot
+	TArray<float> Magnitudes;
+	TArray<TWeakObjectPtr<AActor>> Instigators;
+	TArray<int32> Levels;
+
+	// Index in Classes of each slot
+	TArray<int32> ClassSlots;
+
+	// Incremented every time a slot is freed
+	TArray<int32> Generations;
+
+	TArray<int32> FreeSlots;
+
+	// Classes of all buffs ever stored. Class slots are never released.
+	UPROPERTY()
+	TArray<UClass*> Classes;
+
+	// Slots of the buffs of each class, by index in Classes
+	TArray<FSlotList> SlotsByClass;
+
+	// Stacking groups of all buffs ever stored, by index. Group indices are never released.
+	TMap<FGameplayTag, int32> GroupIndices;
+
+	// Slot of the applied buff of each group or INDEX_NONE
+	TArray<int32> GroupSlots;
+
+	// Index in GroupSlots of each slot or INDEX_NONE
+	TArray<int32> SlotGroups;
+
+	// Open-addressed table of buff slots by buff pointer (linear probing). Power of two size.
+	TArray<int32> HashTable;
+
+	// Slots of the buffs with each identifying tag
+	TMap<FGameplayTag, FSlotList> SlotsByExactTag;
+
+	// Slots of the buffs with each identifying tag or any of its children
+	TMap<FGameplayTag, FSlotList> SlotsByTag;
+
+	int32 NumBuffs = 0;
+
+	// Incremented every time a buff is added or removed, or its count changes
+	uint32 Version = 0;
+
+
+public:
+
+	// @return slot of a buff or INDEX_NONE
+	int32 Find(const UBuff* Buff) const;
+
+	bool Contains(const UBuff* Buff) const { return Find(Buff) != INDEX_NONE; }
+
+	// Adds a buff that is not stored yet
+	// @return slot of the buff
+	int32 Add(UBuff* Buff, int32 Count);
+
+	void RemoveAt(int32 Slot);
+	void Empty();
+
+	int32 Num() const { return NumBuffs; }
+
+	// @return end of the slot range. Some slots in it may be free.
+	int32 GetMaxSlot() const { return Buffs.Num(); }
+
+	// @return a number that changes every time buffs or their counts change
+	uint32 GetVersion() const { return Version; }
+
+	bool IsValidSlot(int32 Slot) const { return Buffs.IsValidIndex(Slot) && Buffs[Slot] != nullptr; }
+
+	UBuff* GetBuff(int32 Slot) const { return Buffs[Slot]; }
+	int32 GetCount(int32 Slot) const { return Counts[Slot]; }
+	void SetCount(int32 Slot, int32 Count)
+	{
+		Counts[Slot] = Count;
+		++Version;
+	}
+	FBuffCount GetBuffCount(int32 Slot) const { return { Buffs[Slot], Counts[Slot] }; }
+
+	FBuffSpec GetSpec(int32 Slot) const
+	{
+		return { Buffs[Slot], Magnitudes[Slot], Instigators[Slot].Get(), Levels[Slot] };
+	}
+
+	// Sets the parameters of a spec. Its buff must be the one of the slot.
+	void SetSpec(int32 Slot, const FBuffSpec& Spec)
+	{
+		check(Spec.Buff == Buffs[Slot]);
+		Magnitudes[Slot] = Spec.Magnitude;
+		Instigators[Slot] = Spec.Instigator;
+		Levels[Slot] = Spec.Level;
+	}
+
+	FBuffHandle MakeHandle(int32 Slot) const;
+
+	// @return slot of a handle or INDEX_NONE if its buff was removed
+	int32 Resolve(FBuffHandle Handle) const;
+
+	bool HasClass(const UClass* Class) const;
+
+	// @return slot of the applied buff of a stacking group or INDEX_NONE
+	int32 FindGroupSlot(const FGameplayTag& Group) const
+	{
+		const int32* GroupIndex = GroupIndices.Find(Group);
+		return GroupIndex? GroupSlots[*GroupIndex] : INDEX_NONE;
+	}
+
+	// Adds all buffs of a class to an array
+	void GetBuffsOfClass(const UClass* Class, TArray<FBuffCount>& OutBuffs) const;
+
+	void GetAllBuffs(TArray<FBuffCount>& OutBuffs) const;
+
+	// Adds all buffs with an identifying tag to an array
+	// @param bExact if false, buffs with children of the tag are included
+	void GetBuffsByTag(const FGameplayTag& Tag, bool bExact, TArray<FBuffCount>& OutBuffs) const;
+
+	// @return number of buffs with an identifying tag
+	int32 CountBuffsByTag(const FGameplayTag& Tag, bool bExact) const;
+
+	// Calls Callback(Slot) for every stored buff
+	template<typename Func>
+	void ForEachSlot(Func Callback) const;
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+
+	int32 FindClassSlot(const UClass* Class) const;
+	int32 GetHashIndex(const UBuff* Buff) const;
+	void InsertHash(int32 Slot);
+	void RemoveHash(int32 Slot);
+	void Rehash(int32 NewSize);
+
+	void AddTagIndex(int32 Slot);
+	void RemoveTagIndex(int32 Slot);
+
+	const FSlotList* FindSlotsByTag(const FGameplayTag& Tag, bool bExact) const
+	{
+		return (bExact? SlotsByExactTag : SlotsByTag).Find(Tag);
+	}
+};
+
+
+template<typename Func>
+inline void FBuffStore::ForEachSlot(Func Callback) const
+{
+	for (int32 Slot = 0; Slot < Buffs.Num(); ++Slot)
+	{
+		if (Buffs[Slot])
+		{
+			Callback(Slot);
+		}
+	}
+}
+
+inline FBuffHandle FBuffStore::MakeHandle(int32 Slot) const
+{
+	return IsValidSlot(Slot)? FBuffHandle{ Slot, Generations[Slot] } : FBuffHandle{};
+}
+
+inline int32 FBuffStore::Resolve(FBuffHandle Handle) const
+{
+	return IsValidSlot(Handle.Index) && Generations[Handle.Index] == Handle.Generation? Handle.Index : INDEX_NONE;
+}
+
+inline bool FBuffStore::HasClass(const UClass* Class) const
+{
+	const int32 ClassSlot = FindClassSlot(Class);
+	return ClassSlot != INDEX_NONE && SlotsByClass[ClassSlot].Num() > 0;
+}
+
+inline int32 FBuffStore::FindClassSlot(const UClass* Class) const
+{
+	return Classes.IndexOfByKey(Class);
+}
+
+inline int32 FBuffStore::GetHashIndex(const UBuff* Buff) const
+{
+	return GetTypeHash(Buff) & (HashTable.Num() - 1);
+}
@@ -10,6 +10,60 @@
 class UBuff;
 struct FBuffCount;
 
+
+USTRUCT()
+struct FBuffLifetimeEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	float EndTime = 0.f;
+
+	UPROPERTY()
+	UBuff* Buff = nullptr;
+
+
+	FBuffLifetimeEntry() {}
+	FBuffLifetimeEntry(float EndTime, UBuff* Buff) : EndTime(EndTime), Buff(Buff) {}
+
+	// Sorts the earliest expiration first
+	bool operator<(const FBuffLifetimeEntry& Other) const
+	{
+		return EndTime < Other.EndTime;
+	}
+};
+
+
+// Ring buffer of the end times of each stack of a buff, earliest first
+USTRUCT()
+struct FBuffStackLifetimes
+{
+	GENERATED_BODY()
+
+private:
+
+	// Capacity is always a power of two
+	TArray<float, TInlineAllocator<4>> EndTimes;
+	int32 Head = 0;
+	int32 NumStacks = 0;
+
+
+public:
+
+	int32 Num() const { return NumStacks; }
+
+	float Front() const { return EndTimes[Head]; }
+
+	float Get(int32 Index) const
+	{
+		return EndTimes[(Head + Index) & (EndTimes.Num() - 1)];
+	}
+
+	void Push(float EndTime);
+	void PopFront(int32 Count);
+};
+
+
 USTRUCT()
 struct FBuffsLifetimeCounter : public FSASOwnedStruct
 {
@@ -21,14 +75,35 @@ protected:
 	UPROPERTY()
 	TMap<UBuff*, float> LifetimePerBuff;
 
+	// Min-heap of expirations. Entries not matching LifetimePerBuff are outdated and skipped when popped.
+	UPROPERTY()
+	TArray<FBuffLifetimeEntry> ExpirationQueue;
+
+	// End times of each stack of buffs with per-stack lifetimes. Only the earliest one is queued.
+	UPROPERTY()
+	TMap<UBuff*, FBuffStackLifetimes> LifetimePerStack;
+
 
 public:
 
 	void Start(const TSet<FBuffCount>& Buffs);
+	// Restarts the lifetime of all stacks of started buffs. Counts are ignored.
+	void Refresh(const TSet<FBuffCount>& Buffs);
 	void Reset(const TSet<FBuffCount>& Buffs);
 	void ResetAll();
 
+	// @return seconds until a buff, or its next stack, expires
 	float GetRemaining(const UBuff* Buff) const;
 
+	// Adds seconds until each stack of a buff, or the buff, expires
+	void GetRemainingTimes(const UBuff* Buff, TArray<float>& OutRemaining) const;
+
+	// Replaces the lifetime of a started buff
+	// @param Remaining seconds until each stack, or the buff, expires. Earliest first.
+	void SetRemainingTimes(UBuff* Buff, TArrayView<const float> Remaining);
+
+	// @return true if any buff lifetime is running
+	bool HasPending() const { return LifetimePerBuff.Num() > 0 || LifetimePerStack.Num() > 0; }
+
 	void Tick();
 };
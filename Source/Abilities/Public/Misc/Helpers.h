@@ -3,6 +3,7 @@
 #pragma once
 
 #include <CoreMinimal.h>
+#include <UObject/Class.h>
 
 
 UENUM(BlueprintType)
@@ -10,4 +11,12 @@ enum class EAllAny : uint8
 {
 	All,
 	Any
-};
\ No newline at end of file
+};
+
+// @return true if a Blueprint class overrides an event. Otherwise calling it only reaches native code,
+// so its _Implementation can be called directly.
+inline bool IsEventImplementedInBlueprint(const UClass* Class, FName EventName)
+{
+	const UFunction* Function = Class? Class->FindFunctionByName(EventName) : nullptr;
+	return Function && !Function->GetOwnerClass()->HasAnyClassFlags(CLASS_Native);
+}
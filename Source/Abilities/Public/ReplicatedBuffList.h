@@ -0,0 +1,104 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <Engine/NetSerialization.h>
+
+#include "Buff.h"
+#include "ReplicatedBuffList.generated.h"
+
+
+class UAbilitiesComponent;
+struct FReplicatedBuffList;
+
+
+USTRUCT()
+struct FReplicatedBuff : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	UBuff* Buff = nullptr;
+
+	UPROPERTY()
+	int32 Count = 0;
+
+	// Spec parameters. Instigators are server only
+	UPROPERTY()
+	float Magnitude = 1.f;
+
+	UPROPERTY()
+	int32 Level = 1;
+
+	// Increased when the lifetime of the buff restarts without changing its count
+	UPROPERTY()
+	uint8 NumRefreshes = 0;
+
+	// Last NumRefreshes received by this client
+	UPROPERTY(NotReplicated)
+	uint8 ReceivedRefreshes = 0;
+
+
+	FReplicatedBuff() {}
+	FReplicatedBuff(const FBuffSpec& Spec, int32 Count)
+		: Buff(Spec.Buff), Count(Count), Magnitude(Spec.Magnitude), Level(Spec.Level)
+	{}
+
+	FBuffSpec GetSpec() const { return { Buff, Magnitude, nullptr, Level }; }
+
+	void PreReplicatedRemove(const FReplicatedBuffList& List);
+	void PostReplicatedAdd(const FReplicatedBuffList& List);
+	void PostReplicatedChange(const FReplicatedBuffList& List);
+};
+
+
+/**
+ * Buffs of a component and their counts replicated as a delta.
+ * Only changed items are sent, and clients that become relevant receive all current buffs.
+ */
+USTRUCT()
+struct ABILITIES_API FReplicatedBuffList : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+private:
+
+	UPROPERTY()
+	TArray<FReplicatedBuff> Items;
+
+	// Component notified on clients when items are received
+	UPROPERTY(NotReplicated)
+	UAbilitiesComponent* Owner = nullptr;
+
+
+public:
+
+	void Setup(UAbilitiesComponent& InOwner) { Owner = &InOwner; }
+	UAbilitiesComponent* GetOwner() const { return Owner; }
+
+	// Sets the replicated count and spec of a buff. Removes it if count is 0.
+	void SetCount(const FBuffSpec& Spec, int32 Count);
+
+	// Notifies clients that the lifetime of a buff restarted
+	void Refresh(const UBuff* Buff);
+
+	void Empty();
+
+	int32 Num() const { return Items.Num(); }
+	const TArray<FReplicatedBuff>& GetItems() const { return Items; }
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParams)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FReplicatedBuff, FReplicatedBuffList>(Items, DeltaParams, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FReplicatedBuffList> : public TStructOpsTypeTraitsBase2<FReplicatedBuffList>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true
+	};
+};
@@ -19,6 +19,7 @@ namespace UnrealBuildTool.Rules
 				"Engine",
 				"CoreUObject",
                 "Automatron",
+                "GameplayTags",
                 "Abilities"
 			});
 
@@ -4,6 +4,7 @@
 
 #include "Helpers/TestHelpers.h"
 #include "Helpers/TestAbility.h"
+#include "Helpers/TestTags.h"
 
 
 #if WITH_DEV_AUTOMATION_TESTS
@@ -181,6 +182,210 @@ void FAbilityTestSpec_Abilities::Define()
 			TestFalse(TEXT("Is Running"), Ability->IsRunning());
 		});
 
+		It("Calls native events without Blueprint", [this]()
+		{
+			UTestAbility* Ability = Component->GetEquippedAbility<UTestAbility>();
+			TestTrue(TEXT("No Blueprint events"), Ability->FindBlueprintEvents() == EAbilityBlueprintEvent::None);
+			TestFalse(TEXT("Tick in Blueprint"), Ability->IsBlueprintEventImplemented(EAbilityBlueprintEvent::Tick));
+
+			int32 NumTicks = 0;
+			Ability->OnTick.AddLambda([&NumTicks]() { ++NumTicks; });
+
+			TestTrue(TEXT("Activated"), Component->CastAbility<UTestAbility>());
+			GetWorld()->Tick(LEVELTICK_All, 0.1f);
+			TestEqual(TEXT("Native ticks"), NumTicks, 1);
+
+			const int32 NumTagsChanged = Ability->NumTagsChanged;
+			Component->AddTag(FAbilitiesTestTags::A);
+			TestEqual(TEXT("Native tag changes"), Ability->NumTagsChanged, NumTagsChanged + 1);
+
+			Ability->OnTick.Clear();
+		});
+
+		It("Calls native overrides of Blueprint events", [this]()
+		{
+			UTestAbility* Ability = Component->GetEquippedAbility<UTestAbility>();
+
+			TestTrue(TEXT("Activated"), Component->CastAbility<UTestAbility>());
+			TestEqual(TEXT("Native overrides called"), Ability->NumEventActivate, 1);
+		});
+
+		AfterEach([this]()
+		{
+			RemoveTestComponent(Component);
+			ShutdownWorld();
+		});
+	});
+
+	Describe("Interrupt", [this]()
+	{
+		BeforeEach([this]()
+		{
+			CreateWorld();
+			Component = AddTestComponent();
+			Component->EquipAbility<UTestAbility_Interrupt>();
+
+			auto* Ability = Component->GetEquippedAbility<UTestAbility_Interrupt>();
+			Ability->SetInterruptTags(FGameplayTagContainer{ FAbilitiesTestTags::A });
+		});
+
+		It("Is interrupted by a received tag", [this]()
+		{
+			auto* Ability = Component->GetEquippedAbility<UTestAbility_Interrupt>();
+			Component->CastAbility<UTestAbility_Interrupt>();
+
+			Component->AddTag(FAbilitiesTestTags::B);
+			TestTrue(TEXT("Is Activated after other tag"), Ability->IsActivated());
+
+			Component->AddTag(FAbilitiesTestTags::A);
+			TestFalse(TEXT("Is Activated after interrupt tag"), Ability->IsActivated());
+			TestTrue(TEXT("Was Cancelled"), Ability->IsCancelled());
+		});
+
+		It("Is not interrupted while idle", [this]()
+		{
+			auto* Ability = Component->GetEquippedAbility<UTestAbility_Interrupt>();
+
+			Component->AddTag(FAbilitiesTestTags::A);
+			Component->RemoveTag(FAbilitiesTestTags::A);
+			Component->CastAbility<UTestAbility_Interrupt>();
+
+			TestTrue(TEXT("Is Activated"), Ability->IsActivated());
+		});
+
+		It("Stops listening after finishing", [this]()
+		{
+			auto* Ability = Component->GetEquippedAbility<UTestAbility_Interrupt>();
+			Component->CastAbility<UTestAbility_Interrupt>();
+			Ability->Cancel(false);
+			TestEqual(TEXT("Interrupt listeners"), Component->GetNumInterruptListeners(), 0);
+
+			const int32 NumStateChanges = Ability->NumStateChanges;
+			Component->AddTag(FAbilitiesTestTags::A);
+			TestEqual(TEXT("State changes after interrupt tag"), Ability->NumStateChanges, NumStateChanges);
+		});
+
+		AfterEach([this]()
+		{
+			RemoveTestComponent(Component);
+			ShutdownWorld();
+		});
+	});
+
+	Describe("Cooldown", [this]()
+	{
+		BeforeEach([this]()
+		{
+			CreateWorld();
+			Component = AddTestComponent();
+			Component->EquipAbility<UTestAbility_Cooldown>();
+		});
+
+		It("Starts on activation", [this]()
+		{
+			TestFalse(TEXT("Is cooling down before activation"), Component->IsCoolingDown(UTestAbility_Cooldown::StaticClass()));
+
+			Component->CastAbility<UTestAbility_Cooldown>();
+
+			TestTrue(TEXT("Is cooling down"), Component->IsCoolingDown(UTestAbility_Cooldown::StaticClass()));
+			TestEqual(TEXT("Remaining cooldown"), Component->GetRemainingCooldown(UTestAbility_Cooldown::StaticClass()), 1.f);
+		});
+
+		It("Finishes after duration", [this]()
+		{
+			auto* Ability = Component->GetEquippedAbility<UTestAbility_Cooldown>();
+			Component->CastAbility<UTestAbility_Cooldown>();
+
+			GetWorld()->Tick(LEVELTICK_All, 0.5f);
+			TestTrue(TEXT("Is cooling down before duration"), Ability->IsCoolingDown());
+
+			GetWorld()->Tick(LEVELTICK_All, 0.6f);
+			TestFalse(TEXT("Is cooling down after duration"), Ability->IsCoolingDown());
+			TestEqual(TEXT("Cooldown ready notifications"), Ability->NumCooldownsReady, 1);
+		});
+
+		It("Can reset all", [this]()
+		{
+			Component->CastAbility<UTestAbility_Cooldown>();
+			Component->GetCooldowns().ResetAll();
+
+			TestFalse(TEXT("Is cooling down"), Component->IsCoolingDown(UTestAbility_Cooldown::StaticClass()));
+			TestEqual(TEXT("Remaining cooldown"), Component->GetRemainingCooldown(UTestAbility_Cooldown::StaticClass()), 0.f);
+		});
+
+		AfterEach([this]()
+		{
+			RemoveTestComponent(Component);
+			ShutdownWorld();
+		});
+	});
+
+	Describe("Availability", [this]()
+	{
+		BeforeEach([this]()
+		{
+			CreateWorld();
+			Component = AddTestComponent();
+			Component->SetCacheAvailability(true);
+			Component->EquipAbility<UTestAbility>();
+			Component->EquipAbility<UTestAbility_Cooldown>();
+		});
+
+		It("Caches until invalidated", [this]()
+		{
+			auto* Ability = Component->GetEquippedAbility<UTestAbility>();
+			TestTrue(TEXT("Can activate"), Component->CanActivate(UTestAbility::StaticClass()));
+
+			Ability->bEnableActivation = false;
+			TestTrue(TEXT("Can activate before invalidation"), Component->CanActivate(UTestAbility::StaticClass()));
+
+			Component->InvalidateAvailability();
+			TestFalse(TEXT("Can activate after invalidation"), Component->CanActivate(UTestAbility::StaticClass()));
+		});
+
+		It("Updates with cooldowns", [this]()
+		{
+			auto* Ability = Component->GetEquippedAbility<UTestAbility_Cooldown>();
+			TestEqual(TEXT("Castable abilities"), Component->GetCastableAbilities().Num(), 2);
+
+			Component->CastAbility<UTestAbility_Cooldown>();
+			Ability->Cancel();
+			TestFalse(TEXT("Can cast while cooling down"), Component->CanCast(UTestAbility_Cooldown::StaticClass()));
+			TestEqual(TEXT("Castable abilities"), Component->GetCastableAbilities().Num(), 1);
+
+			GetWorld()->Tick(LEVELTICK_All, 1.1f);
+			TestTrue(TEXT("Can cast after cooldown"), Component->CanCast(UTestAbility_Cooldown::StaticClass()));
+		});
+
+		It("Skips unequipped abilities", [this]()
+		{
+			Component->UnequipAbility<UTestAbility>();
+			TArray<UAbility*> Castable = Component->GetCastableAbilities();
+			TestEqual(TEXT("Castable abilities"), Castable.Num(), 1);
+			TestFalse(TEXT("Unequipped ability is not castable"), Castable.ContainsByPredicate([](UAbility* Ability) {
+				return Ability->IsA<UTestAbility>();
+			}));
+
+			Component->SetCacheAvailability(false);
+			TestEqual(TEXT("Castable abilities without cache"), Component->GetCastableAbilities().Num(), 1);
+
+			Component->EquipAbility<UTestAbility>();
+			TestEqual(TEXT("Castable abilities after re-equip"), Component->GetCastableAbilities().Num(), 2);
+		});
+
+		It("Only asks the ability when not cached", [this]()
+		{
+			auto* Ability = Component->GetEquippedAbility<UTestAbility_Cooldown>();
+			Component->CastAbility<UTestAbility_Cooldown>();
+			Ability->Cancel();
+			TestFalse(TEXT("Can cast while cooling down"), Component->CanCast(UTestAbility_Cooldown::StaticClass()));
+
+			// Without the cache, CanCast and CanActivate keep their behaviour from before caching existed
+			Component->SetCacheAvailability(false);
+			TestTrue(TEXT("Ability allows casting"), Component->CanCast(UTestAbility_Cooldown::StaticClass()));
+			TestTrue(TEXT("Ability allows activation"), Component->CanActivate(UTestAbility_Cooldown::StaticClass()));
+		});
+
 		AfterEach([this]()
 		{
 			RemoveTestComponent(Component);
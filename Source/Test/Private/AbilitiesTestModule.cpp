@@ -1,5 +1,13 @@
 // Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
 
 #include "AbilitiesTestModule.h"
+#include "Helpers/TestTags.h"
 
 IMPLEMENT_MODULE(FAbilitiesTestModule, AbilitiesTest);
+
+
+void FAbilitiesTestModule::StartupModule()
+{
+	// Native tags must be added before the engine finishes initializing
+	FAbilitiesTestTags::AddNativeTags();
+}
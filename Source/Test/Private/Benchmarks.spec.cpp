@@ -0,0 +1,451 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include <CoreMinimal.h>
+#include <HAL/PlatformTime.h>
+#include <Serialization/BitWriter.h>
+#include <UObject/UnrealType.h>
+
+#include "Helpers/TestHelpers.h"
+#include "Helpers/TestAbility.h"
+#include "Helpers/TestBuff.h"
+#include "Helpers/TestTags.h"
+
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/************************************************************************/
+/* BENCHMARKS                                                           */
+/************************************************************************/
+
+// Buff layout used by components before FBuffStore. Kept to compare against it.
+struct FLegacyBuffStorage
+{
+	struct FClassContainer
+	{
+		UClass* Class = nullptr;
+		TSet<UBuff*> Buffs;
+
+		friend uint32 GetTypeHash(const FClassContainer& Container) { return GetTypeHash(Container.Class); }
+		bool operator==(const FClassContainer& Other) const { return Class == Other.Class; }
+	};
+
+	TSet<FBuffCount> Buffs;
+	TSet<FClassContainer> BuffsByClass;
+
+
+	void Add(UBuff* Buff)
+	{
+		FClassContainer SearchContainer{ Buff->GetClass() };
+		if (FClassContainer* Container = BuffsByClass.Find(SearchContainer))
+		{
+			Container->Buffs.Add(Buff);
+		}
+		else
+		{
+			SearchContainer.Buffs.Add(Buff);
+			BuffsByClass.Add(MoveTemp(SearchContainer));
+		}
+		Buffs.Add({ Buff, 1 });
+	}
+
+	void Remove(UBuff* Buff)
+	{
+		Buffs.Remove(Buff);
+		const FSetElementId ClassId = BuffsByClass.FindId({ Buff->GetClass() });
+		auto& ContainerBuffs = BuffsByClass[ClassId].Buffs;
+		ContainerBuffs.Remove(Buff);
+		if (ContainerBuffs.Num() <= 0)
+		{
+			BuffsByClass.Remove(ClassId);
+		}
+	}
+
+	SIZE_T GetAllocatedSize() const
+	{
+		SIZE_T Size = Buffs.GetAllocatedSize() + BuffsByClass.GetAllocatedSize();
+		for (const FClassContainer& Container : BuffsByClass)
+		{
+			Size += Container.Buffs.GetAllocatedSize();
+		}
+		return Size;
+	}
+};
+
+
+class FAbilityTestSpec_Benchmarks : public FAbilityTestSpec
+{
+	GENERATE_SPEC(FAbilityTestSpec_Benchmarks, "Abilities.Benchmark",
+		EAutomationTestFlags::PerfFilter |
+		EAutomationTestFlags::EditorContext |
+		EAutomationTestFlags::ServerContext
+	);
+
+	static constexpr int32 NumFrames = 60;
+	static constexpr float FrameTime = 1.f / 60.f;
+
+	TArray<UAbilitiesComponent*> SpawnComponents(int32 Num, bool bTickWithSubsystem, bool bTicking)
+	{
+		TArray<UAbilitiesComponent*> Components;
+		Components.Reserve(Num);
+		for (int32 I = 0; I < Num; ++I)
+		{
+			AAbilityTestActor* Actor = AddTestActor();
+			// Only measure abilities ticking
+			Actor->SetActorTickEnabled(false);
+
+			UAbilitiesComponent* Component = Actor->Abilities;
+			Component->SetTickWithSubsystem(bTickWithSubsystem);
+			if (bTicking)
+			{
+				Component->EquipAbility<UTestAbility>();
+				Component->CastAbility<UTestAbility>();
+			}
+			Components.Add(Component);
+		}
+		return Components;
+	}
+
+	// @return average milliseconds per world frame
+	double MeasureWorldTick()
+	{
+		UWorld* World = GetWorld();
+		// Warm up
+		World->Tick(LEVELTICK_All, FrameTime);
+
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 I = 0; I < NumFrames; ++I)
+		{
+			World->Tick(LEVELTICK_All, FrameTime);
+		}
+		return (FPlatformTime::Seconds() - StartTime) * 1000.0 / NumFrames;
+	}
+
+	void BenchmarkTick(int32 Num, bool bTicking)
+	{
+		double PerComponentMs, SubsystemMs;
+		{
+			CreateWorld();
+			SpawnComponents(Num, false, bTicking);
+			PerComponentMs = MeasureWorldTick();
+			ShutdownWorld();
+		}
+		{
+			CreateWorld();
+			SpawnComponents(Num, true, bTicking);
+			SubsystemMs = MeasureWorldTick();
+			ShutdownWorld();
+		}
+
+		AddInfo(FString::Printf(TEXT("%d %s components: Per-component tick %.3fms | Subsystem tick %.3fms"),
+			Num, bTicking? TEXT("ticking") : TEXT("idle"), PerComponentMs, SubsystemMs));
+	}
+
+	void BenchmarkBuffStorage(int32 NumBuffs)
+	{
+		static constexpr int32 NumRounds = 100;
+
+		// Mix of plain, stackable and timed buffs
+		TArray<UBuff*> TestBuffs;
+		for (int32 I = 0; I < NumBuffs; ++I)
+		{
+			UTestBuff* Buff = NewObject<UTestBuff>();
+			if (I % 3 == 1)
+			{
+				Buff->SetStackable();
+			}
+			else if (I % 3 == 2)
+			{
+				Buff->SetLifetime(1.f);
+			}
+			Buff->AddToRoot();
+			TestBuffs.Add(Buff);
+		}
+
+		// Accumulated so lookups are not optimized away
+		int32 NumFound = 0;
+
+		FLegacyBuffStorage Legacy;
+		SIZE_T LegacyBytes = 0;
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Round = 0; Round < NumRounds; ++Round)
+		{
+			for (UBuff* Buff : TestBuffs)
+			{
+				Legacy.Add(Buff);
+			}
+			for (UBuff* Buff : TestBuffs)
+			{
+				NumFound += Legacy.Buffs.Contains(Buff);
+			}
+			LegacyBytes = Legacy.GetAllocatedSize();
+			for (UBuff* Buff : TestBuffs)
+			{
+				Legacy.Remove(Buff);
+			}
+		}
+		const double LegacyMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		FBuffStore Store;
+		SIZE_T StoreBytes = 0;
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Round = 0; Round < NumRounds; ++Round)
+		{
+			for (UBuff* Buff : TestBuffs)
+			{
+				Store.Add(Buff, 1);
+			}
+			for (UBuff* Buff : TestBuffs)
+			{
+				NumFound += Store.Contains(Buff);
+			}
+			StoreBytes = Store.GetAllocatedSize();
+			for (UBuff* Buff : TestBuffs)
+			{
+				Store.RemoveAt(Store.Find(Buff));
+			}
+		}
+		const double StoreMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		for (UBuff* Buff : TestBuffs)
+		{
+			Buff->RemoveFromRoot();
+			Buff->MarkPendingKill();
+		}
+
+		TestEqual(TEXT("Found all buffs"), NumFound, NumBuffs * NumRounds * 2);
+		AddInfo(FString::Printf(TEXT("%d buffs x%d rounds: TSet layout %.3fms %dB | Buff store %.3fms %dB"),
+			NumBuffs, NumRounds, LegacyMs, int32(LegacyBytes), StoreMs, int32(StoreBytes)));
+	}
+
+	// Writes the replicated properties of a struct with their net serializers.
+	// Object references are written as a packed index, the way a network GUID is sent.
+	static void NetSerializeStruct(FBitWriter& Writer, const UScriptStruct* Struct, const void* Data, TMap<const UObject*, uint32>& ObjectIds)
+	{
+		for (TFieldIterator<FProperty> It{ Struct }; It; ++It)
+		{
+			if (It->HasAnyPropertyFlags(CPF_RepSkip))
+			{
+				continue;
+			}
+
+			void* Value = const_cast<void*>(It->ContainerPtrToValuePtr<void>(Data));
+			if (const FObjectPropertyBase* ObjectProperty = CastField<FObjectPropertyBase>(*It))
+			{
+				const UObject* Object = ObjectProperty->GetObjectPropertyValue(Value);
+				uint32 Id = ObjectIds.FindOrAdd(Object, uint32(ObjectIds.Num() + 1));
+				Writer.SerializeIntPacked(Id);
+			}
+			else
+			{
+				It->NetSerializeItem(Writer, nullptr, Value);
+			}
+		}
+	}
+
+	// Serializes the parameters of the previous reliable RPC for one buff change
+	static int64 SerializeBuffsChangedRPC(const TArray<FBuffCount>& Buffs, EBuffOperation Change, TMap<const UObject*, uint32>& ObjectIds)
+	{
+		FBitWriter Writer{ 0, true };
+		uint16 NumBuffs = uint16(Buffs.Num());
+		Writer << NumBuffs;
+		for (const FBuffCount& Buff : Buffs)
+		{
+			NetSerializeStruct(Writer, FBuffCount::StaticStruct(), &Buff, ObjectIds);
+		}
+		uint8 ChangeValue = uint8(Change);
+		Writer.SerializeBits(&ChangeValue, FMath::CeilLogTwo64(StaticEnum<EBuffOperation>()->GetMaxEnumValue()));
+		return Writer.GetNumBits();
+	}
+
+	// Serializes the delta of the replicated buff list: its header, deleted ids and changed items
+	static int64 SerializeBuffListDelta(const FReplicatedBuffList& List, const TArray<const FReplicatedBuff*>& Changed, const TArray<int32>& Deleted, TMap<const UObject*, uint32>& ObjectIds)
+	{
+		FBitWriter Writer{ 0, true };
+		int32 Header[4] = { List.ArrayReplicationKey, List.ArrayReplicationKey - 1, Deleted.Num(), Changed.Num() };
+		Writer.Serialize(Header, sizeof(Header));
+		for (int32 DeletedId : Deleted)
+		{
+			Writer << DeletedId;
+		}
+		for (const FReplicatedBuff* Item : Changed)
+		{
+			int32 Id = Item->ReplicationID;
+			Writer << Id;
+			NetSerializeStruct(Writer, FReplicatedBuff::StaticStruct(), Item, ObjectIds);
+		}
+		return Writer.GetNumBits();
+	}
+
+	// Compares what reaches a client while buffs change every frame: the previous reliable RPC per change
+	// against the replicated buff list delta sent once the frame ends.
+	// Payloads are serialized with the property net serializers. Bunch and RPC headers are not counted.
+	void BenchmarkBuffReplication(int32 NumBuffs)
+	{
+		CreateWorld();
+		UAbilitiesComponent* Component = AddTestComponent();
+
+		TArray<UBuff*> TestBuffs;
+		for (int32 I = 0; I < NumBuffs; ++I)
+		{
+			UBuff* Buff = NewObject<UTestBuff_Stackable>();
+			Buff->AddToRoot();
+			TestBuffs.Add(Buff);
+		}
+
+		TMap<const UObject*, uint32> ObjectIds;
+		int64 NumRPCs = 0;
+		int64 RPCBits = 0;
+		int64 NumItemsSent = 0;
+		int64 ListBits = 0;
+		TMap<int32, int32> SentKeys;
+		TArray<const FReplicatedBuff*> ChangedItems;
+		TArray<int32> DeletedIds;
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			// Every buff gains two stacks and loses one. Each change that went through was one RPC.
+			for (UBuff* Buff : TestBuffs)
+			{
+				const FBuffCount Applied{ Buff, 2 };
+				if (Component->ApplyBuff(Applied))
+				{
+					++NumRPCs;
+					RPCBits += SerializeBuffsChangedRPC({ Applied }, EBuffOperation::Added, ObjectIds);
+				}
+				const FBuffCount Removed{ Buff, 1 };
+				if (Component->RemoveBuff(Removed))
+				{
+					++NumRPCs;
+					RPCBits += SerializeBuffsChangedRPC({ Removed }, EBuffOperation::Removed, ObjectIds);
+				}
+			}
+
+			// Items are sent once per frame if their key changed
+			const FReplicatedBuffList& List = Component->GetReplicatedBuffs();
+			ChangedItems.Reset();
+			DeletedIds.Reset();
+			TSet<int32> CurrentIds;
+			for (const FReplicatedBuff& Item : List.GetItems())
+			{
+				CurrentIds.Add(Item.ReplicationID);
+				int32& SentKey = SentKeys.FindOrAdd(Item.ReplicationID, INDEX_NONE);
+				if (SentKey != Item.ReplicationKey)
+				{
+					SentKey = Item.ReplicationKey;
+					ChangedItems.Add(&Item);
+				}
+			}
+			for (auto It = SentKeys.CreateIterator(); It; ++It)
+			{
+				if (!CurrentIds.Contains(It.Key()))
+				{
+					DeletedIds.Add(It.Key());
+					It.RemoveCurrent();
+				}
+			}
+
+			if (ChangedItems.Num() > 0 || DeletedIds.Num() > 0)
+			{
+				NumItemsSent += ChangedItems.Num();
+				ListBits += SerializeBuffListDelta(List, ChangedItems, DeletedIds, ObjectIds);
+			}
+		}
+
+		for (UBuff* Buff : TestBuffs)
+		{
+			Buff->RemoveFromRoot();
+			Buff->MarkPendingKill();
+		}
+		RemoveTestComponent(Component);
+		ShutdownWorld();
+
+		TestEqual(TEXT("Each buff is sent once per frame"), NumItemsSent, int64(NumBuffs) * NumFrames);
+		TestTrue(TEXT("Fewer messages are sent"), NumItemsSent < NumRPCs);
+		AddInfo(FString::Printf(TEXT("%d buffs churning for %d frames: %lld reliable RPCs %lldB | %lld replicated items %lldB"),
+			NumBuffs, NumFrames, NumRPCs, (RPCBits + 7) / 8, NumItemsSent, (ListBits + 7) / 8));
+	}
+
+	void BenchmarkTagRequirements(int32 NumChecks)
+	{
+		const FGameplayTagContainer Tags = FGameplayTagContainer::CreateFromArray(TArray<FGameplayTag>{
+			FAbilitiesTestTags::A, FAbilitiesTestTags::B
+		});
+		const FGameplayTagContainer RequiredTags = Tags;
+		const FGameplayTagContainer BlockedTags{ FAbilitiesTestTags::Other };
+
+		FAbilityTagRequirements Requirements;
+		Requirements.Compile(RequiredTags, BlockedTags);
+		const FAbilityTagMask TagMask{ Tags };
+
+		// Accumulated so checks are not optimized away
+		int32 NumPassed = 0;
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 I = 0; I < NumChecks; ++I)
+		{
+			NumPassed += Tags.HasAllExact(RequiredTags) && !Tags.HasAnyExact(BlockedTags);
+		}
+		const double ContainerMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 I = 0; I < NumChecks; ++I)
+		{
+			NumPassed += Requirements.Check(TagMask);
+		}
+		const double MaskMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		TestEqual(TEXT("Both checks pass"), NumPassed, NumChecks * 2);
+		AddInfo(FString::Printf(TEXT("%d checks: Tag containers %.3fms | Tag masks %.3fms"),
+			NumChecks, ContainerMs, MaskMs));
+	}
+};
+
+void FAbilityTestSpec_Benchmarks::Define()
+{
+	Describe("Component Tick", [this]()
+	{
+		for (const int32 Num : { 100, 1000, 10000 })
+		{
+			It(FString::Printf(TEXT("Idle x%d"), Num), [this, Num]()
+			{
+				BenchmarkTick(Num, false);
+			});
+
+			It(FString::Printf(TEXT("Ticking x%d"), Num), [this, Num]()
+			{
+				BenchmarkTick(Num, true);
+			});
+		}
+	});
+
+	Describe("Buff Storage", [this]()
+	{
+		for (const int32 Num : { 4, 16, 64 })
+		{
+			It(FString::Printf(TEXT("Apply and remove x%d"), Num), [this, Num]()
+			{
+				BenchmarkBuffStorage(Num);
+			});
+		}
+	});
+
+	Describe("Buff Replication", [this]()
+	{
+		It("Messages x50", [this]()
+		{
+			BenchmarkBuffReplication(50);
+		});
+	});
+
+	Describe("Tag Requirements", [this]()
+	{
+		for (const int32 Num : { 10000, 1000000 })
+		{
+			It(FString::Printf(TEXT("Checks x%d"), Num), [this, Num]()
+			{
+				BenchmarkTagRequirements(Num);
+			});
+		}
+	});
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
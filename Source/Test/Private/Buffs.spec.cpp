@@ -2,8 +2,11 @@
 
 #include <CoreMinimal.h>
 
+#include "AbilitiesWorldSubsystem.h"
 #include "Helpers/TestHelpers.h"
+#include "Helpers/TestAbility.h"
 #include "Helpers/TestBuff.h"
+#include "Helpers/TestTags.h"
 
 
 #if WITH_DEV_AUTOMATION_TESTS
@@ -37,6 +40,16 @@ class FAbilityTestSpec_Buffs : public FAbilityTestSpec
 		}
 	}
 
+	// Receives a replicated buff count as a client would
+	void ReceiveReplicatedBuff(UBuff* Buff, int32 Count)
+	{
+		FReplicatedBuffList List;
+		List.Setup(*Component);
+		List.SetCount(Buff, Count);
+		FReplicatedBuff Item = List.GetItems()[0];
+		Item.PostReplicatedChange(List);
+	}
+
 	UAbilitiesComponent* Component = nullptr;
 };
 
@@ -254,6 +267,823 @@ void FAbilityTestSpec_Buffs::Define()
 		});
 	});
 
+	Describe("Stack Delta", [this]()
+	{
+		It("Only applies the delta when stacks change", [this]()
+		{
+			auto* Buff = LoadBuffMock<UTestBuff>();
+			Buff->SetOnlyStackDelta();
+
+			Component->ApplyBuff(Buff);
+			Component->ApplyBuff({ Buff, 2 });
+			TestEqual("Stack deltas", Buff->NumStackDeltas, 1);
+			TestTrue("Changes applied", Buff->bChangesApplied);
+			TestEqual("Buff Count", Buff->LastCount, 3);
+
+			Component->RemoveBuff(Buff);
+			TestEqual("Stack deltas", Buff->NumStackDeltas, 2);
+			TestTrue("Changes applied", Buff->bChangesApplied);
+			TestEqual("Buff Count", Buff->LastCount, 2);
+
+			UnloadBuffMock(Buff);
+		});
+	});
+
+	Describe("Revert", [this]()
+	{
+		It("Reverts a replaced spec before storing the new one", [this]()
+		{
+			auto* Buff = LoadBuffMock<UTestBuff_Stackable>();
+
+			Component->ApplyBuffSpec({ Buff, 2.f });
+			Component->ApplyBuffSpec({ Buff, 3.f });
+			TestEqual("Count while reverting", Buff->CountWhileReverting, 1);
+			TestEqual("Magnitude while reverting", Buff->MagnitudeWhileReverting, 2.f);
+			TestEqual("Count", Component->GetBuffCount(Buff), 2);
+
+			UnloadBuffMock(Buff);
+		});
+
+		It("Reverts reset buffs while still applied", [this]()
+		{
+			auto* Buff = LoadBuffMock<UTestBuff_Stackable>();
+
+			Component->ApplyBuffSpec({ Buff, 2.f });
+			Component->ApplyBuff(Buff);
+			TestTrue("Reset", Component->ResetBuffs());
+			TestEqual("Count while reverting", Buff->CountWhileReverting, 2);
+			TestEqual("Magnitude while reverting", Buff->MagnitudeWhileReverting, 2.f);
+			TestFalse("Has buff", Component->HasBuff(Buff));
+
+			UnloadBuffMock(Buff);
+		});
+	});
+
+	Describe("Blueprint Events", [this]()
+	{
+		It("Calls native events without Blueprint", [this]()
+		{
+			auto* Buff = LoadBuffMock<UTestBuff>();
+			Buff->SetOnlyStackDelta();
+			TestTrue("No Blueprint events", Buff->FindBlueprintEvents() == EBuffBlueprintEvent::None);
+			TestFalse("Apply in Blueprint", Buff->IsBlueprintEventImplemented(EBuffBlueprintEvent::ApplyEffects));
+
+			Component->ApplyBuff(Buff);
+			TestTrue("Native apply", Buff->bChangesApplied);
+
+			Component->ApplyBuff(Buff);
+			TestEqual("Native stack deltas", Buff->NumStackDeltas, 1);
+
+			Component->RemoveBuff({ Buff, 2 });
+			TestFalse("Native revert", Buff->bChangesApplied);
+
+			UnloadBuffMock(Buff);
+		});
+
+		It("Calls native overrides of Blueprint events", [this]()
+		{
+			auto* Buff = LoadBuffMock<UTestBuff>();
+
+			Component->ApplyBuff(Buff);
+			TestEqual("Native overrides called", Buff->NumEventApplyEffects, 1);
+			TestTrue("Native apply", Buff->bChangesApplied);
+
+			UnloadBuffMock(Buff);
+		});
+	});
+
+	Describe("Replication", [this]()
+	{
+		It("Replicates each buff by its policy", [this]()
+		{
+			auto* AllBuff = LoadBuffMock<UTestBuff>();
+			auto* OwnerBuff = LoadBuffMock<UTestBuff>();
+			auto* ServerBuff = LoadBuffMock<UTestBuff>();
+			OwnerBuff->SetReplication(EBuffReplicationPolicy::OwningClient);
+			ServerBuff->SetReplication(EBuffReplicationPolicy::OnlyServer);
+
+			Component->ApplySingleBuffs({ AllBuff, OwnerBuff, ServerBuff });
+			TestEqual("Replicated to all", Component->GetReplicatedBuffs().Num(), 1);
+			TestEqual("Replicated to owner", Component->GetOwnerReplicatedBuffs().Num(), 1);
+
+			Component->RemoveBuff(OwnerBuff);
+			TestEqual("Replicated to owner after remove", Component->GetOwnerReplicatedBuffs().Num(), 0);
+
+			UnloadBuffMock(AllBuff);
+			UnloadBuffMock(OwnerBuff);
+			UnloadBuffMock(ServerBuff);
+		});
+	});
+
+	Describe("Many Targets", [this]()
+	{
+		It("Applies and removes on every target", [this]()
+		{
+			auto* Buff = LoadBuffMock<UTestBuff>();
+			UAbilitiesComponent* Other = AddTestComponent();
+			const TArray<UAbilitiesComponent*> Targets{ Component, Other };
+
+			TestEqual("Applied targets", UAbilitiesComponent::ApplyBuffsToMany(Targets, { Buff }), 2);
+			TestTrue("Has buff", Component->HasBuff(Buff) && Other->HasBuff(Buff));
+
+			TestEqual("Removed targets", UAbilitiesComponent::RemoveBuffsFromMany(Targets, { Buff }), 2);
+			TestFalse("Has buff", Component->HasBuff(Buff) || Other->HasBuff(Buff));
+
+			RemoveTestComponent(Other);
+			UnloadBuffMock(Buff);
+		});
+
+		It("Defers notifications to next frame", [this]()
+		{
+			auto* Buff = LoadBuffMock<UTestBuff>();
+			const TArray<UAbilitiesComponent*> Targets{ Component };
+
+			UAbilitiesComponent::ApplyBuffsToMany(Targets, { Buff });
+			TestEqual("Replicated before flush", Component->GetReplicatedBuffs().Num(), 0);
+
+			GetWorld()->Tick(LEVELTICK_All, 0.1f);
+			TestEqual("Replicated after flush", Component->GetReplicatedBuffs().Num(), 1);
+
+			UnloadBuffMock(Buff);
+		});
+
+		It("Notifies deferred changes before later changes", [this]()
+		{
+			auto* Subsystem = GetWorld()->GetSubsystem<UAbilitiesWorldSubsystem>();
+			auto* Buff = LoadBuffMock<UTestBuff>();
+			const TArray<UAbilitiesComponent*> Targets{ Component };
+			Component->SetCoalesceBuffEvents(true);
+
+			int32 NumBroadcasts = 0;
+			Component->OnBuffsChanged.AddLambda([&NumBroadcasts](const FBuffChanges& Changes)
+			{
+				++NumBroadcasts;
+			});
+
+			// The deferred apply is notified before the removal, so the net change is none
+			UAbilitiesComponent::ApplyBuffsToMany(Targets, { Buff });
+			TestEqual("Replicated before removal", Component->GetReplicatedBuffs().Num(), 0);
+			Component->RemoveBuff(Buff);
+
+			Subsystem->Tick(0.f);
+			TestEqual("Broadcasts", NumBroadcasts, 0);
+			TestEqual("Replicated", Component->GetReplicatedBuffs().Num(), 0);
+
+			Component->OnBuffsChanged.Clear();
+			UnloadBuffMock(Buff);
+		});
+	});
+
+	Describe("Lifetime", [this]()
+	{
+		It("Is removed when lifetime ends", [this]()
+		{
+			auto* Buff = LoadBuffMock<UTestBuff>();
+			Buff->SetLifetime(1.f);
+
+			TestTrue("Applied a buff", Component->ApplyBuff(Buff));
+			TestTrue("Remaining lifetime", Component->GetBuffRemainingLifetime(Buff) > 0.f);
+
+			GetWorld()->Tick(LEVELTICK_All, 0.5f);
+			TestTrue("Has buff before lifetime ends", Component->HasBuff(Buff));
+
+			GetWorld()->Tick(LEVELTICK_All, 0.6f);
+			TestFalse("Has buff after lifetime ends", Component->HasBuff(Buff));
+
+			UnloadBuffMock(Buff);
+		});
+
+		It("Restarts lifetime when reapplied", [this]()
+		{
+			auto* Buff = LoadBuffMock<UTestBuff>();
+			Buff->SetLifetime(1.f);
+
+			Component->ApplyBuff(Buff);
+			GetWorld()->Tick(LEVELTICK_All, 0.6f);
+			Component->RemoveBuff(Buff);
+			Component->ApplyBuff(Buff);
+
+			// The first lifetime would have finished here
+			GetWorld()->Tick(LEVELTICK_All, 0.6f);
+			TestTrue("Has buff", Component->HasBuff(Buff));
+
+			GetWorld()->Tick(LEVELTICK_All, 0.6f);
+			TestFalse("Has buff after lifetime ends", Component->HasBuff(Buff));
+
+			UnloadBuffMock(Buff);
+		});
+
+		It("Expires each stack on its own", [this]()
+		{
+			UTestBuff* Buff = LoadBuffMock<UTestBuff>();
+			Buff->SetStackLifetime(1.f);
+			Component->ApplyBuff({ Buff, 2 });
+
+			GetWorld()->Tick(LEVELTICK_All, 0.5f);
+			Component->ApplyBuff(Buff);
+			TestEqual("Stacks", Component->GetBuffCount(Buff), 3);
+
+			GetWorld()->Tick(LEVELTICK_All, 0.6f);
+			TestEqual("Stacks after first lifetime ends", Component->GetBuffCount(Buff), 1);
+
+			GetWorld()->Tick(LEVELTICK_All, 0.5f);
+			TestFalse("Has buff after last lifetime ends", Component->HasBuff(Buff));
+
+			UnloadBuffMock(Buff);
+		});
+	});
+
+	Describe("Period", [this]()
+	{
+		It("Fires while applied", [this]()
+		{
+			auto* Subsystem = GetWorld()->GetSubsystem<UAbilitiesWorldSubsystem>();
+			UTestBuff* Buff = LoadBuffMock<UTestBuff>();
+			Buff->SetPeriod(1.f);
+			Component->ApplyBuff(Buff);
+			TestEqual("Periodic buffs", Subsystem->GetNumPeriodicBuffs(), 1);
+
+			GetWorld()->Tick(LEVELTICK_All, 0.5f);
+			TestEqual("Periods before one period", Buff->NumPeriods, 0);
+
+			GetWorld()->Tick(LEVELTICK_All, 0.6f);
+			TestEqual("Periods after one period", Buff->NumPeriods, 1);
+
+			Component->RemoveBuff(Buff);
+			TestEqual("Periodic buffs after removal", Subsystem->GetNumPeriodicBuffs(), 0);
+
+			GetWorld()->Tick(LEVELTICK_All, 1.f);
+			TestEqual("Periods after removal", Buff->NumPeriods, 1);
+
+			UnloadBuffMock(Buff);
+		});
+
+		It("Fires a period after being applied", [this]()
+		{
+			UTestBuff* Buff1 = LoadBuffMock<UTestBuff>();
+			UTestBuff* Buff2 = LoadBuffMock<UTestBuff>();
+			Buff1->SetPeriod(1.f);
+			Buff2->SetPeriod(1.f);
+			Component->ApplyBuff(Buff1);
+
+			GetWorld()->Tick(LEVELTICK_All, 0.6f);
+			Component->ApplyBuff(Buff2);
+
+			GetWorld()->Tick(LEVELTICK_All, 0.5f);
+			TestEqual("Periods of first buff", Buff1->NumPeriods, 1);
+			TestEqual("Periods of second buff before one period", Buff2->NumPeriods, 0);
+
+			GetWorld()->Tick(LEVELTICK_All, 0.6f);
+			TestEqual("Periods of second buff after one period", Buff2->NumPeriods, 1);
+
+			UnloadBuffMock(Buff1);
+			UnloadBuffMock(Buff2);
+		});
+
+		It("Limits periods fired per tick", [this]()
+		{
+			UTestBuff* Buff = LoadBuffMock<UTestBuff>();
+			Buff->SetPeriod(SMALL_NUMBER);
+			Component->ApplyBuff(Buff);
+
+			GetWorld()->Tick(LEVELTICK_All, 1.f);
+			TestTrue("Fired", Buff->NumPeriods > 0);
+			TestTrue("Periods are limited", Buff->NumPeriods <= UAbilitiesWorldSubsystem::MaxPeriodsPerTick);
+
+			UnloadBuffMock(Buff);
+		});
+	});
+
+	Describe("Coalesced Events", [this]()
+	{
+		It("Broadcasts net changes once per frame", [this]()
+		{
+			auto* Subsystem = GetWorld()->GetSubsystem<UAbilitiesWorldSubsystem>();
+			UTestBuff_Stackable* Buff1 = LoadBuffMock<UTestBuff_Stackable>();
+			UTestBuff* Buff2 = LoadBuffMock<UTestBuff>();
+			Component->SetCoalesceBuffEvents(true);
+
+			int32 NumBroadcasts = 0;
+			TArray<FBuffCount> Applied, Removed, StackChanged;
+			Component->OnBuffsChanged.AddLambda([&](const FBuffChanges& Changes)
+			{
+				++NumBroadcasts;
+				Applied = Changes.Applied;
+				Removed = Changes.Removed;
+				StackChanged = Changes.StackChanged;
+			});
+
+			Component->ApplyBuff(Buff1);
+			Component->ApplyBuff(Buff1);
+			Component->ApplyBuff(Buff2);
+			Component->RemoveBuff(Buff2);
+			TestEqual("Broadcasts before flush", NumBroadcasts, 0);
+
+			Subsystem->Tick(0.f);
+			TestEqual("Broadcasts", NumBroadcasts, 1);
+			TestEqual("Applied", Applied.Num(), 1);
+			TestEqual("Applied count", Applied.Num() > 0? Applied[0].Count : 0, 2);
+			TestEqual("Removed", Removed.Num(), 0);
+
+			Component->RemoveBuff(Buff1);
+			Subsystem->Tick(0.f);
+			TestEqual("Broadcasts after removal", NumBroadcasts, 2);
+			TestEqual("Stack changed", StackChanged.Num(), 1);
+
+			Component->OnBuffsChanged.Clear();
+			UnloadBuffMock(Buff1);
+			UnloadBuffMock(Buff2);
+		});
+	});
+
+	Describe("Handles", [this]()
+	{
+		It("Find an applied buff", [this]()
+		{
+			UTestBuff_Stackable* Buff = LoadBuffMock<UTestBuff_Stackable>();
+			Component->ApplyBuff({ Buff, 2 });
+
+			const FBuffHandle Handle = Component->GetBuffHandle(Buff);
+			TestTrue("Handle is set", Handle.IsSet());
+			TestTrue("Handle buff", Component->GetBuffFromHandle(Handle) == Buff);
+			TestEqual("Handle count", Component->GetBuffCountFromHandle(Handle), 2);
+
+			UnloadBuffMock(Buff);
+		});
+
+		It("Are invalid after the buff is removed", [this]()
+		{
+			UTestBuff* Buff1 = LoadBuffMock<UTestBuff>();
+			UTestBuff* Buff2 = LoadBuffMock<UTestBuff>();
+
+			Component->ApplyBuff(Buff1);
+			const FBuffHandle Handle = Component->GetBuffHandle(Buff1);
+			Component->RemoveBuff(Buff1);
+
+			// Reuses the slot of Buff1
+			Component->ApplyBuff(Buff2);
+			TestTrue("Removed buff", Component->GetBuffFromHandle(Handle) == nullptr);
+			TestTrue("New buff", Component->HasBuff(Buff2));
+
+			UnloadBuffMock(Buff1);
+			UnloadBuffMock(Buff2);
+		});
+
+		It("Keep buffs of each class", [this]()
+		{
+			UTestBuff* Buff1 = LoadBuffMock<UTestBuff>();
+			UTestBuff* Buff2 = LoadBuffMock<UTestBuff>();
+			UTestBuff_Stackable* Buff3 = LoadBuffMock<UTestBuff_Stackable>();
+			Component->ApplySingleBuffs({ Buff1, Buff2, Buff3 });
+
+			TArray<FBuffCount> BuffsOfClass;
+			Component->GetBuffsOfClass(UTestBuff::StaticClass(), BuffsOfClass);
+			TestEqual("Buffs of class", BuffsOfClass.Num(), 2);
+
+			TSet<FBuffCount> BuffSetOfClass;
+			Component->GetBuffsOfClass(UTestBuff::StaticClass(), BuffSetOfClass);
+			TestTrue("Buff set of class", BuffSetOfClass.Num() == 2 && BuffSetOfClass.Contains(Buff1));
+
+			Component->RemoveBuff(Buff3);
+			TestFalse("Has removed class", Component->HasBuffOfClass(UTestBuff_Stackable::StaticClass()));
+			TestEqual("Num buffs", Component->GetNumBuffs(), 2);
+
+			UnloadBuffMock(Buff1);
+			UnloadBuffMock(Buff2);
+			UnloadBuffMock(Buff3);
+		});
+
+		It("List all buffs with their counts", [this]()
+		{
+			UTestBuff* Buff1 = LoadBuffMock<UTestBuff>();
+			UTestBuff_Stackable* Buff2 = LoadBuffMock<UTestBuff_Stackable>();
+			Component->ApplySingleBuffs({ Buff1, Buff2 });
+			TestEqual("All buffs", Component->GetAllBuffs().Num(), 2);
+
+			Component->ApplyBuff(Buff2);
+			const FBuffCount* Stacked = Component->GetAllBuffs().Find(Buff2);
+			TestTrue("Count after stacking", Stacked && Stacked->Count == 2);
+
+			Component->RemoveBuff(Buff1);
+			TestFalse("Has removed buff", Component->GetAllBuffs().Contains(Buff1));
+
+			UnloadBuffMock(Buff1);
+			UnloadBuffMock(Buff2);
+		});
+	});
+
+	Describe("Tags", [this]()
+	{
+		It("Compiles net tag changes", [this]()
+		{
+			const FGameplayTagContainer TagsA{ FAbilitiesTestTags::A };
+			const FGameplayTagContainer TagsAB = FGameplayTagContainer::CreateFromArray(TArray<FGameplayTag>{
+				FAbilitiesTestTags::A, FAbilitiesTestTags::B
+			});
+			const FGameplayTagContainer TagsB{ FAbilitiesTestTags::B };
+			const FGameplayTagContainer TagsOther{ FAbilitiesTestTags::Other };
+
+			const FGameplayTagContainer* const Added[] = { &TagsA, &TagsAB };
+			const FGameplayTagContainer* const Removed[] = { &TagsB, &TagsOther };
+			FBuffTagChanges Changes;
+			Changes.Compile(Added, Removed);
+			TestEqual("Grants", Changes.Grants.Num(), 2);
+			TestEqual("Repeated grants", Changes.Grants.FilterByPredicate([](const FGameplayTag& Tag) {
+				return Tag == FAbilitiesTestTags::A;
+			}).Num(), 2);
+			TestEqual("Revokes", Changes.Revokes.Num(), 1);
+			TestTrue("Revoked tag", Changes.Revokes.Contains(FAbilitiesTestTags::Other));
+			TestFalse("Cancelled tag granted", Changes.Grants.Contains(FAbilitiesTestTags::B));
+			TestFalse("Cancelled tag revoked", Changes.Revokes.Contains(FAbilitiesTestTags::B));
+
+			const FGameplayTagContainer* const Both[] = { &TagsAB };
+			Changes.Compile(Both, Both);
+			TestTrue("All changes cancelled", Changes.IsEmpty());
+		});
+
+		It("Finds buffs by tag", [this]()
+		{
+			UTestBuff* BuffA = LoadBuffMock<UTestBuff>();
+			UTestBuff* BuffB = LoadBuffMock<UTestBuff>();
+			BuffA->SetTags(FGameplayTagContainer{ FAbilitiesTestTags::A });
+			BuffB->SetTags(FGameplayTagContainer{ FAbilitiesTestTags::B });
+			Component->ApplySingleBuffs({ BuffA, BuffB });
+
+			TArray<FBuffCount> FoundBuffs;
+			Component->GetBuffsByTag(FAbilitiesTestTags::A, FoundBuffs, true);
+			TestEqual("Buffs with exact tag", FoundBuffs.Num(), 1);
+			TestEqual("Buffs with parent tag", Component->CountBuffsByTag(FAbilitiesTestTags::Parent), 2);
+			TestEqual("Buffs with exact parent tag", Component->CountBuffsByTag(FAbilitiesTestTags::Parent, true), 0);
+
+			UnloadBuffMock(BuffA);
+			UnloadBuffMock(BuffB);
+		});
+
+		It("Removes buffs by tag", [this]()
+		{
+			UTestBuff* BuffA = LoadBuffMock<UTestBuff>();
+			UTestBuff* BuffOther = LoadBuffMock<UTestBuff>();
+			BuffA->SetTags(FGameplayTagContainer{ FAbilitiesTestTags::A });
+			BuffOther->SetTags(FGameplayTagContainer{ FAbilitiesTestTags::Other });
+			Component->ApplySingleBuffs({ BuffA, BuffOther });
+
+			TestTrue("Removed", Component->RemoveBuffsByTag(FAbilitiesTestTags::Parent));
+			TestFalse("Has tagged buff", Component->HasBuff(BuffA));
+			TestTrue("Has other buff", Component->HasBuff(BuffOther));
+			TestEqual("Buffs with parent tag", Component->CountBuffsByTag(FAbilitiesTestTags::Parent), 0);
+
+			UnloadBuffMock(BuffA);
+			UnloadBuffMock(BuffOther);
+		});
+
+		It("Applies and reverts tags as one change", [this]()
+		{
+			UTestBuff* Buff = LoadBuffMock<UTestBuff>();
+			Buff->SetTagChanges(FGameplayTagContainer{ FAbilitiesTestTags::A }, FGameplayTagContainer{ FAbilitiesTestTags::B });
+			Component->AddTag(FAbilitiesTestTags::B);
+
+			int32 NumDeltas = 0;
+			Component->OnTagsDelta.AddLambda([&NumDeltas](const FAbilityTagsDelta& Delta)
+			{
+				++NumDeltas;
+			});
+
+			Component->ApplyBuff(Buff);
+			TestEqual("Notifications on apply", NumDeltas, 1);
+			TestTrue("Has applied tag", Component->GetTags().HasTagExact(FAbilitiesTestTags::A));
+			TestFalse("Has removed tag", Component->GetTags().HasTagExact(FAbilitiesTestTags::B));
+
+			Component->RemoveBuff(Buff);
+			TestEqual("Notifications on revert", NumDeltas, 2);
+			TestFalse("Has applied tag after revert", Component->GetTags().HasTagExact(FAbilitiesTestTags::A));
+
+			Component->OnTagsDelta.Clear();
+			UnloadBuffMock(Buff);
+		});
+	});
+
+	Describe("Attributes", [this]()
+	{
+		BeforeEach([this]()
+		{
+			Component->SetAttributeBaseValue(FAbilitiesTestTags::A, 100.f);
+		});
+
+		It("Aggregates modifiers", [this]()
+		{
+			UTestBuff* Buff = LoadBuffMock<UTestBuff>();
+			Buff->SetStackable();
+			Buff->AddModifier(EAttributeModifierOp::Additive, 10.f);
+			Buff->AddModifier(EAttributeModifierOp::Multiplicative, 1.5f);
+
+			Component->ApplyBuff(Buff);
+			TestEqual("Value", Component->GetAttributeValue(FAbilitiesTestTags::A), 165.f);
+
+			Component->ApplyBuff(Buff);
+			TestEqual("Value with two stacks", Component->GetAttributeValue(FAbilitiesTestTags::A), 270.f);
+
+			Component->RemoveBuff({ Buff, 2 });
+			TestEqual("Value after removal", Component->GetAttributeValue(FAbilitiesTestTags::A), 100.f);
+			TestEqual("Base value", Component->GetAttributeBaseValue(FAbilitiesTestTags::A), 100.f);
+
+			UnloadBuffMock(Buff);
+		});
+
+		It("Overrides with the last buff", [this]()
+		{
+			UTestBuff* Buff1 = LoadBuffMock<UTestBuff>();
+			UTestBuff* Buff2 = LoadBuffMock<UTestBuff>();
+			Buff1->AddModifier(EAttributeModifierOp::Override, 5.f);
+			Buff2->AddModifier(EAttributeModifierOp::Override, 7.f);
+
+			Component->ApplyBuff(Buff1);
+			Component->ApplyBuff(Buff2);
+			TestEqual("Value", Component->GetAttributeValue(FAbilitiesTestTags::A), 7.f);
+
+			Component->RemoveBuff(Buff2);
+			TestEqual("Value after removal", Component->GetAttributeValue(FAbilitiesTestTags::A), 5.f);
+
+			UnloadBuffMock(Buff1);
+			UnloadBuffMock(Buff2);
+		});
+
+		It("Scales modifiers by spec magnitude", [this]()
+		{
+			UTestBuff* Buff = LoadBuffMock<UTestBuff>();
+			Buff->SetStackable();
+			Buff->AddModifier(EAttributeModifierOp::Additive, 10.f);
+
+			Component->ApplyBuffSpec({ Buff, 2.f });
+			TestEqual("Value", Component->GetAttributeValue(FAbilitiesTestTags::A), 120.f);
+
+			// Latest spec replaces the previous one
+			Component->ApplyBuffSpec({ Buff, 3.f });
+			TestEqual("Value with two stacks", Component->GetAttributeValue(FAbilitiesTestTags::A), 160.f);
+			TestEqual("Spec magnitude", Component->GetBuffSpec(Buff).Magnitude, 3.f);
+
+			Component->RemoveBuff({ Buff, 2 });
+			TestEqual("Value after removal", Component->GetAttributeValue(FAbilitiesTestTags::A), 100.f);
+			TestEqual("Spec magnitude after removal", Component->GetBuffSpec(Buff).Magnitude, 1.f);
+
+			UnloadBuffMock(Buff);
+		});
+
+		It("Scales multiplicative modifiers by spec magnitude", [this]()
+		{
+			UTestBuff* Buff = LoadBuffMock<UTestBuff>();
+			Buff->SetStackable();
+			Buff->AddModifier(EAttributeModifierOp::Multiplicative, 1.5f);
+
+			Component->ApplyBuffSpec({ Buff, 2.f });
+			TestEqual("Value", Component->GetAttributeValue(FAbilitiesTestTags::A), 300.f);
+
+			Component->ApplyBuffSpec({ Buff, 2.f });
+			TestEqual("Value with two stacks", Component->GetAttributeValue(FAbilitiesTestTags::A), 900.f);
+
+			UnloadBuffMock(Buff);
+		});
+
+		It("Keeps override order when stacks change", [this]()
+		{
+			UTestBuff* Buff1 = LoadBuffMock<UTestBuff>();
+			UTestBuff* Buff2 = LoadBuffMock<UTestBuff>();
+			Buff1->AddModifier(EAttributeModifierOp::Override, 5.f);
+			Buff2->AddModifier(EAttributeModifierOp::Override, 7.f);
+			Buff1->SetStackable();
+
+			Component->ApplyBuff(Buff1);
+			Component->ApplyBuff(Buff2);
+			Component->ApplyBuff(Buff1);
+			TestEqual("Value", Component->GetAttributeValue(FAbilitiesTestTags::A), 7.f);
+
+			UnloadBuffMock(Buff1);
+			UnloadBuffMock(Buff2);
+		});
+	});
+
+	Describe("Stacking Groups", [this]()
+	{
+		It("Rejects buffs of an applied group", [this]()
+		{
+			UTestBuff* Buff1 = LoadBuffMock<UTestBuff>();
+			UTestBuff* Buff2 = LoadBuffMock<UTestBuff>();
+			Buff1->SetStackingGroup(FAbilitiesTestTags::A, EBuffStackingPolicy::Reject);
+			Buff2->SetStackingGroup(FAbilitiesTestTags::A, EBuffStackingPolicy::Reject);
+
+			Component->ApplyBuff(Buff1);
+			TestFalse("Applied second buff", Component->ApplyBuff(Buff2));
+			TestTrue("Has first buff", Component->HasBuff(Buff1));
+
+			Component->RemoveBuff(Buff1);
+			TestTrue("Applied second buff after removal", Component->ApplyBuff(Buff2));
+
+			UnloadBuffMock(Buff1);
+			UnloadBuffMock(Buff2);
+		});
+
+		It("Replaces buffs of the group", [this]()
+		{
+			UTestBuff* Buff1 = LoadBuffMock<UTestBuff>();
+			UTestBuff* Buff2 = LoadBuffMock<UTestBuff>();
+			Buff1->SetStackingGroup(FAbilitiesTestTags::A, EBuffStackingPolicy::Replace);
+			Buff2->SetStackingGroup(FAbilitiesTestTags::A, EBuffStackingPolicy::Replace);
+
+			Component->ApplyBuff(Buff1);
+			Component->ApplyBuff(Buff2);
+			TestFalse("Has first buff", Component->HasBuff(Buff1));
+			TestTrue("Has second buff", Component->HasBuff(Buff2));
+
+			UnloadBuffMock(Buff1);
+			UnloadBuffMock(Buff2);
+		});
+
+		It("Keeps the highest magnitude", [this]()
+		{
+			UTestBuff* Buff1 = LoadBuffMock<UTestBuff>();
+			UTestBuff* Buff2 = LoadBuffMock<UTestBuff>();
+			UTestBuff* Buff3 = LoadBuffMock<UTestBuff>();
+			Buff1->SetStackingGroup(FAbilitiesTestTags::A, EBuffStackingPolicy::KeepHighestMagnitude);
+			Buff2->SetStackingGroup(FAbilitiesTestTags::A, EBuffStackingPolicy::KeepHighestMagnitude);
+			Buff3->SetStackingGroup(FAbilitiesTestTags::A, EBuffStackingPolicy::KeepHighestMagnitude);
+
+			Component->ApplyBuffSpec({ Buff1, 2.f });
+			TestFalse("Applied lower magnitude", Component->ApplyBuffSpec({ Buff2, 1.f }));
+			TestTrue("Applied higher magnitude", Component->ApplyBuffSpec({ Buff3, 3.f }));
+			TestFalse("Has first buff", Component->HasBuff(Buff1));
+			TestTrue("Has third buff", Component->HasBuff(Buff3));
+
+			UnloadBuffMock(Buff1);
+			UnloadBuffMock(Buff2);
+			UnloadBuffMock(Buff3);
+		});
+
+		It("Refreshes the lifetime of all stacks of the applied buff", [this]()
+		{
+			UTestBuff* Buff1 = LoadBuffMock<UTestBuff>();
+			UTestBuff* Buff2 = LoadBuffMock<UTestBuff>();
+			Buff1->SetStackingGroup(FAbilitiesTestTags::A, EBuffStackingPolicy::RefreshDuration);
+			Buff2->SetStackingGroup(FAbilitiesTestTags::A, EBuffStackingPolicy::RefreshDuration);
+			Buff1->SetStackLifetime(1.f);
+
+			Component->ApplyBuff({ Buff1, 2 });
+			GetWorld()->Tick(LEVELTICK_All, 0.6f);
+
+			TestTrue("Refreshed", Component->ApplyBuff(Buff2));
+			TestFalse("Has second buff", Component->HasBuff(Buff2));
+			const FReplicatedBuff* Item = Component->GetReplicatedBuffs().GetItems().FindByPredicate([Buff1](const FReplicatedBuff& Other)
+			{
+				return Other.Buff == Buff1;
+			});
+			TestTrue("Replicated refresh", Item && Item->NumRefreshes == 1);
+
+			GetWorld()->Tick(LEVELTICK_All, 0.6f);
+			TestEqual("Stacks after previous lifetime", Component->GetBuffCount(Buff1), 2);
+
+			GetWorld()->Tick(LEVELTICK_All, 0.5f);
+			TestFalse("Has buff after refreshed lifetime", Component->HasBuff(Buff1));
+
+			UnloadBuffMock(Buff1);
+			UnloadBuffMock(Buff2);
+		});
+
+		It("Refreshes its own lifetime when applied again", [this]()
+		{
+			UTestBuff* Buff = LoadBuffMock<UTestBuff>();
+			Buff->SetStackingGroup(FAbilitiesTestTags::A, EBuffStackingPolicy::RefreshDuration);
+			Buff->SetStackLifetime(1.f);
+
+			Component->ApplyBuff({ Buff, 2 });
+			GetWorld()->Tick(LEVELTICK_All, 0.6f);
+
+			TestTrue("Applied again", Component->ApplyBuff(Buff));
+			GetWorld()->Tick(LEVELTICK_All, 0.6f);
+			TestEqual("Stacks after previous lifetime", Component->GetBuffCount(Buff), 3);
+
+			GetWorld()->Tick(LEVELTICK_All, 0.5f);
+			TestFalse("Has buff after refreshed lifetime", Component->HasBuff(Buff));
+
+			UnloadBuffMock(Buff);
+		});
+
+		It("Keeps its highest magnitude when applied again", [this]()
+		{
+			UTestBuff* Buff = LoadBuffMock<UTestBuff>();
+			Buff->SetStackingGroup(FAbilitiesTestTags::A, EBuffStackingPolicy::KeepHighestMagnitude);
+			Buff->SetStackable();
+
+			Component->ApplyBuffSpec({ Buff, 3.f });
+			TestTrue("Applied lower magnitude", Component->ApplyBuffSpec({ Buff, 1.f }));
+			TestEqual("Count", Component->GetBuffCount(Buff), 2);
+			TestEqual("Magnitude", Component->GetBuffSpec(Buff).Magnitude, 3.f);
+
+			Component->ApplyBuffSpec({ Buff, 4.f });
+			TestEqual("Higher magnitude", Component->GetBuffSpec(Buff).Magnitude, 4.f);
+
+			UnloadBuffMock(Buff);
+		});
+	});
+
+	Describe("Prediction", [this]()
+	{
+		It("Reverts rejected predictions", [this]()
+		{
+			Component->EquipAbility<UTestAbility>();
+			UAbility* Ability = Component->GetEquippedAbility<UTestAbility>();
+			UTestBuff* Buff = LoadBuffMock<UTestBuff>();
+
+			// Act as the owning client
+			Component->GetOwner()->SetRole(ROLE_AutonomousProxy);
+
+			TestTrue("Predicted", Component->ApplyPredictedBuff({ Ability, 1 }, Buff));
+			TestEqual("Predicted count", Component->GetBuffCount(Buff), 1);
+
+			Component->RevertPredictedBuffs(Ability, 1);
+			TestEqual("Count after rejection", Component->GetBuffCount(Buff), 0);
+			TestEqual("Pending predictions", Component->GetNumPredictedBuffs(), 0);
+
+			Component->GetOwner()->SetRole(ROLE_Authority);
+			UnloadBuffMock(Buff);
+		});
+
+		It("Confirms acknowledged predictions without applying twice", [this]()
+		{
+			Component->EquipAbility<UTestAbility>();
+			UAbility* Ability = Component->GetEquippedAbility<UTestAbility>();
+			UTestBuff_Stackable* Buff = LoadBuffMock<UTestBuff_Stackable>();
+			Component->GetOwner()->SetRole(ROLE_AutonomousProxy);
+
+			Component->ApplyPredictedBuff({ Ability, 1 }, Buff);
+			ReceiveReplicatedBuff(Buff, 1);
+			TestEqual("Count before acknowledgment", Component->GetBuffCount(Buff), 2);
+
+			Component->ConfirmPredictedBuffs({ Ability, 1 });
+			TestEqual("Count after acknowledgment", Component->GetBuffCount(Buff), 1);
+			TestEqual("Pending predictions", Component->GetNumPredictedBuffs(), 0);
+
+			Component->GetOwner()->SetRole(ROLE_Authority);
+			UnloadBuffMock(Buff);
+		});
+
+		It("Drops acknowledged predictions server didn't apply", [this]()
+		{
+			Component->EquipAbility<UTestAbility>();
+			UAbility* Ability = Component->GetEquippedAbility<UTestAbility>();
+			UTestBuff_Stackable* Buff = LoadBuffMock<UTestBuff_Stackable>();
+			Component->GetOwner()->SetRole(ROLE_AutonomousProxy);
+
+			Component->ApplyPredictedBuff({ Ability, 1 }, Buff);
+			Component->ApplyPredictedBuff({ Ability, 2 }, Buff);
+			Component->ConfirmPredictedBuffs({ Ability, 2 });
+			TestEqual("Count", Component->GetBuffCount(Buff), 0);
+			TestEqual("Pending predictions", Component->GetNumPredictedBuffs(), 0);
+
+			Component->GetOwner()->SetRole(ROLE_Authority);
+			UnloadBuffMock(Buff);
+		});
+
+		It("Confirms predictions of each ability separately", [this]()
+		{
+			Component->EquipAbility<UTestAbility>();
+			Component->EquipAbility<UTestAbility2>();
+			UAbility* Ability1 = Component->GetEquippedAbility<UTestAbility>();
+			UAbility* Ability2 = Component->GetEquippedAbility<UTestAbility2>();
+			UTestBuff_Stackable* Buff = LoadBuffMock<UTestBuff_Stackable>();
+			Component->GetOwner()->SetRole(ROLE_AutonomousProxy);
+
+			Component->ApplyPredictedBuff({ Ability1, 1 }, Buff);
+			Component->ApplyPredictedBuff({ Ability2, 1 }, Buff);
+			ReceiveReplicatedBuff(Buff, 1);
+			Component->ConfirmPredictedBuffs({ Ability1, 1 });
+			TestEqual("Count with one acknowledgment", Component->GetBuffCount(Buff), 2);
+			TestEqual("Pending predictions", Component->GetNumPredictedBuffs(), 1);
+
+			ReceiveReplicatedBuff(Buff, 2);
+			Component->ConfirmPredictedBuffs({ Ability2, 1 });
+			TestEqual("Count with both acknowledged", Component->GetBuffCount(Buff), 2);
+			TestEqual("Pending predictions", Component->GetNumPredictedBuffs(), 0);
+
+			Component->GetOwner()->SetRole(ROLE_Authority);
+			UnloadBuffMock(Buff);
+		});
+
+		It("Doesn't predict conflicts with unique buffs", [this]()
+		{
+			Component->EquipAbility<UTestAbility>();
+			UAbility* Ability = Component->GetEquippedAbility<UTestAbility>();
+			UTestBuff_Unique* Buff1 = LoadBuffMock<UTestBuff_Unique>();
+			UTestBuff_Unique* Buff2 = LoadBuffMock<UTestBuff_Unique>();
+			Component->GetOwner()->SetRole(ROLE_AutonomousProxy);
+
+			ReceiveReplicatedBuff(Buff1, 1);
+			TestFalse("Predicted", Component->ApplyPredictedBuff({ Ability, 1 }, Buff2));
+			TestEqual("Pending predictions", Component->GetNumPredictedBuffs(), 0);
+
+			Component->GetOwner()->SetRole(ROLE_Authority);
+			UnloadBuffMock(Buff1);
+			UnloadBuffMock(Buff2);
+		});
+	});
+
 	AfterEach([this]()
 	{
 		RemoveTestComponent(Component);
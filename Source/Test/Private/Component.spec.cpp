@@ -3,6 +3,11 @@
 #include <CoreMinimal.h>
 
 #include "Helpers/TestHelpers.h"
+#include "Helpers/TestAbility.h"
+#include "Helpers/TestBuff.h"
+#include "Helpers/TestTags.h"
+#include "AbilitiesSnapshot.h"
+#include "AbilitiesWorldSubsystem.h"
 
 
 #if WITH_DEV_AUTOMATION_TESTS
@@ -30,6 +35,430 @@ void FAbilityTestSpec_Component::Define()
 
 		TestActor->Destroy();
 	});
+
+	Describe("Tags", [this]()
+	{
+		BeforeEach([this]()
+		{
+			CreateWorld();
+		});
+
+		It("Notifies every change", [this]()
+		{
+			UAbilitiesComponent* Component = AddTestComponent();
+			Component->EquipAbility<UTestAbility>();
+			auto* Ability = Component->GetEquippedAbility<UTestAbility>();
+
+			Component->AddTag(FAbilitiesTestTags::A);
+			Component->AddTag(FAbilitiesTestTags::B);
+			TestEqual(TEXT("Notifications"), Ability->NumTagsChanged, 2);
+
+			RemoveTestComponent(Component);
+		});
+
+		It("Coalesces changes inside a mutation scope", [this]()
+		{
+			UAbilitiesComponent* Component = AddTestComponent();
+			Component->EquipAbility<UTestAbility>();
+			auto* Ability = Component->GetEquippedAbility<UTestAbility>();
+
+			{
+				FAbilityTagMutationScope Scope{ Component };
+				Component->AddTag(FAbilitiesTestTags::A);
+				{
+					FAbilityTagMutationScope NestedScope{ Component };
+					Component->AddTag(FAbilitiesTestTags::B);
+				}
+				Component->RemoveTag(FAbilitiesTestTags::A);
+				TestEqual(TEXT("Notifications inside scope"), Ability->NumTagsChanged, 0);
+			}
+			TestEqual(TEXT("Notifications after scope"), Ability->NumTagsChanged, 1);
+			TestTrue(TEXT("Has tag B"), Component->GetTags().HasTagExact(FAbilitiesTestTags::B));
+
+			RemoveTestComponent(Component);
+		});
+
+		It("Keeps tags granted more than once", [this]()
+		{
+			UAbilitiesComponent* Component = AddTestComponent();
+
+			Component->AddTag(FAbilitiesTestTags::A);
+			Component->AddTag(FAbilitiesTestTags::A);
+			TestEqual(TEXT("Count"), Component->GetTagCount(FAbilitiesTestTags::A), 2);
+
+			TestFalse(TEXT("First removal"), Component->RemoveTag(FAbilitiesTestTags::A));
+			TestTrue(TEXT("Has tag A"), Component->GetTags().HasTagExact(FAbilitiesTestTags::A));
+
+			TestTrue(TEXT("Last removal"), Component->RemoveTag(FAbilitiesTestTags::A));
+			TestFalse(TEXT("Has tag A"), Component->GetTags().HasTagExact(FAbilitiesTestTags::A));
+			TestFalse(TEXT("Has parent tag"), Component->GetTags().HasTag(FAbilitiesTestTags::Parent));
+
+			RemoveTestComponent(Component);
+		});
+
+		It("Keeps tag counts when registered again", [this]()
+		{
+			UAbilitiesComponent* Component = AddTestComponent();
+			Component->AddTag(FAbilitiesTestTags::A);
+			Component->AddTag(FAbilitiesTestTags::A);
+
+			Component->UnregisterComponent();
+			Component->RegisterComponent();
+			TestEqual(TEXT("Count"), Component->GetTagCount(FAbilitiesTestTags::A), 2);
+
+			TestFalse(TEXT("First removal"), Component->RemoveTag(FAbilitiesTestTags::A));
+			TestTrue(TEXT("Has tag A"), Component->GetTags().HasTagExact(FAbilitiesTestTags::A));
+
+			RemoveTestComponent(Component);
+		});
+
+		It("Applies tag changes as one notification", [this]()
+		{
+			UAbilitiesComponent* Component = AddTestComponent();
+			Component->AddTag(FAbilitiesTestTags::B);
+
+			int32 NumDeltas = 0;
+			Component->OnTagsDelta.AddLambda([&NumDeltas](const FAbilityTagsDelta& Delta)
+			{
+				++NumDeltas;
+			});
+
+			const TArray<FGameplayTag> Grants{ FAbilitiesTestTags::A, FAbilitiesTestTags::A };
+			const TArray<FGameplayTag> Revokes{ FAbilitiesTestTags::B };
+			Component->ApplyTagChanges(Grants, Revokes);
+			TestEqual(TEXT("Notifications"), NumDeltas, 1);
+			TestEqual(TEXT("Count of repeated grant"), Component->GetTagCount(FAbilitiesTestTags::A), 2);
+			TestFalse(TEXT("Has revoked tag"), Component->GetTags().HasTagExact(FAbilitiesTestTags::B));
+
+			const TArray<FGameplayTag> RevokeA{ FAbilitiesTestTags::A };
+			Component->ApplyTagChanges({}, RevokeA);
+			TestEqual(TEXT("Notifications while still granted"), NumDeltas, 1);
+			TestTrue(TEXT("Has tag A"), Component->GetTags().HasTagExact(FAbilitiesTestTags::A));
+
+			Component->ApplyTagChanges({}, RevokeA);
+			TestEqual(TEXT("Notifications after last revoke"), NumDeltas, 2);
+			TestFalse(TEXT("Has tag A"), Component->GetTags().HasTagExact(FAbilitiesTestTags::A));
+
+			Component->OnTagsDelta.Clear();
+			RemoveTestComponent(Component);
+		});
+
+		It("Notifies only the tags that changed", [this]()
+		{
+			UAbilitiesComponent* Component = AddTestComponent();
+			Component->EquipAbility<UTestAbility>();
+			auto* Ability = Component->GetEquippedAbility<UTestAbility>();
+			Component->AddTag(FAbilitiesTestTags::A);
+
+			{
+				FAbilityTagMutationScope Scope{ Component };
+				Component->RemoveTag(FAbilitiesTestTags::A);
+				Component->AddTag(FAbilitiesTestTags::B);
+				Component->AddTag(FAbilitiesTestTags::Other);
+				Component->RemoveTag(FAbilitiesTestTags::Other);
+			}
+			const FAbilityTagsDelta& Delta = Ability->LastTagsDelta;
+			TestTrue(TEXT("Added B"), Delta.Added.HasTagExact(FAbilitiesTestTags::B) && Delta.Added.Num() == 1);
+			TestTrue(TEXT("Removed A"), Delta.Removed.HasTagExact(FAbilitiesTestTags::A) && Delta.Removed.Num() == 1);
+
+			// Adding an existing tag is not a change
+			const int32 NumTagsChanged = Ability->NumTagsChanged;
+			Component->AddTag(FAbilitiesTestTags::B);
+			TestEqual(TEXT("Notifications"), Ability->NumTagsChanged, NumTagsChanged);
+
+			RemoveTestComponent(Component);
+		});
+
+		AfterEach([this]()
+		{
+			ShutdownWorld();
+		});
+	});
+
+	Describe("Subsystem Tick", [this]()
+	{
+		BeforeEach([this]()
+		{
+			CreateWorld();
+		});
+
+		It("Doesn't tick idle components", [this]()
+		{
+			UAbilitiesComponent* Component = AddTestComponent();
+			auto* Subsystem = GetWorld()->GetSubsystem<UAbilitiesWorldSubsystem>();
+
+			TestNotNull(TEXT("Subsystem"), Subsystem);
+			TestEqual(TEXT("Registered components"), Subsystem->GetNumRegistered(), 0);
+
+			RemoveTestComponent(Component);
+		});
+
+		It("Ticks components with ticking abilities", [this]()
+		{
+			UAbilitiesComponent* Component = AddTestComponent();
+			auto* Subsystem = GetWorld()->GetSubsystem<UAbilitiesWorldSubsystem>();
+
+			Component->EquipAbility<UTestAbility>();
+			TestEqual(TEXT("Registered before activation"), Subsystem->GetNumRegistered(), 0);
+
+			Component->CastAbility<UTestAbility>();
+			TestEqual(TEXT("Registered while active"), Subsystem->GetNumRegistered(), 1);
+
+			bool bTicked = false;
+			Component->GetEquippedAbility<UTestAbility>()->OnTick.AddLambda([&bTicked]() { bTicked = true; });
+			Subsystem->Tick(0.1f);
+			TestTrue(TEXT("Ability ticked"), bTicked);
+
+			Component->Cancel<UTestAbility>();
+			TestEqual(TEXT("Registered after cancel"), Subsystem->GetNumRegistered(), 0);
+
+			RemoveTestComponent(Component);
+		});
+
+		It("Unregisters destroyed components", [this]()
+		{
+			UAbilitiesComponent* Component = AddTestComponent();
+			auto* Subsystem = GetWorld()->GetSubsystem<UAbilitiesWorldSubsystem>();
+
+			Component->EquipAbility<UTestAbility>();
+			Component->CastAbility<UTestAbility>();
+			RemoveTestComponent(Component);
+
+			TestEqual(TEXT("Registered components"), Subsystem->GetNumRegistered(), 0);
+		});
+
+		AfterEach([this]()
+		{
+			ShutdownWorld();
+		});
+	});
+
+	Describe("Snapshots", [this]()
+	{
+		BeforeEach([this]()
+		{
+			CreateWorld();
+		});
+
+		It("Restores a captured state", [this]()
+		{
+			UAbilitiesComponent* Component = AddTestComponent();
+			UTestBuff* Buff = NewObject<UTestBuff>();
+			Buff->AddToRoot();
+
+			Component->EquipAbility<UTestAbility>();
+			Component->ApplyBuff(Buff);
+			Component->AddTag(FAbilitiesTestTags::A);
+
+			TArray<uint8> Data;
+			Component->CaptureSnapshot(Data);
+
+			Component->UnequipAbility<UTestAbility>();
+			Component->RemoveBuff(Buff);
+			Component->RemoveTag(FAbilitiesTestTags::A);
+			Component->AddTag(FAbilitiesTestTags::B);
+
+			TestTrue(TEXT("Restored"), Component->RestoreSnapshot(Data));
+			TestTrue(TEXT("Is equipped"), Component->IsEquipped<UTestAbility>());
+			TestEqual(TEXT("Buff count"), Component->GetBuffCount(Buff), 1);
+			TestTrue(TEXT("Has captured tag"), Component->GetTags().HasTagExact(FAbilitiesTestTags::A));
+			TestFalse(TEXT("Has later tag"), Component->GetTags().HasTagExact(FAbilitiesTestTags::B));
+
+			TestFalse(TEXT("Restored invalid data"), Component->RestoreSnapshot(TArray<uint8>{ 1, 2, 3 }));
+
+			Buff->RemoveFromRoot();
+			RemoveTestComponent(Component);
+		});
+
+		It("Restores lifetimes, cooldowns and specs", [this]()
+		{
+			UAbilitiesComponent* Component = AddTestComponent();
+			Component->SetCoalesceBuffEvents(true);
+			UTestBuff* Buff = NewObject<UTestBuff>();
+			UTestBuff* OtherBuff = NewObject<UTestBuff>();
+			Buff->AddToRoot();
+			Buff->SetStackLifetime(1.f);
+			OtherBuff->AddToRoot();
+
+			Component->EquipAbility<UTestAbility_Cooldown>();
+			auto* Ability = Cast<UTestAbility_Cooldown>(Component->GetEquippedAbility(UTestAbility_Cooldown::StaticClass()));
+			Component->ApplyBuffSpec({ Buff, 2.f }, 2);
+			Component->CastAbility<UTestAbility_Cooldown>();
+			Ability->Cancel();
+			GetWorld()->Tick(LEVELTICK_All, 0.4f);
+
+			TArray<uint8> Data;
+			Component->CaptureSnapshot(Data);
+
+			// Same count with another spec and lifetime
+			Component->RemoveBuff(Buff);
+			Component->ApplyBuffSpec({ Buff, 5.f });
+			Component->ApplyBuff(OtherBuff);
+			Component->AddTag(FAbilitiesTestTags::B);
+			Ability->ResetCooldown();
+			GetWorld()->Tick(LEVELTICK_All, 0.1f);
+
+			int32 NumTagsDeltas = 0;
+			Component->OnTagsDelta.AddLambda([&NumTagsDeltas](const FAbilityTagsDelta& Delta)
+			{
+				++NumTagsDeltas;
+			});
+			int32 NumBuffsChanged = 0;
+			Component->OnBuffsChanged.AddLambda([&NumBuffsChanged](const FBuffChanges& Changes)
+			{
+				++NumBuffsChanged;
+			});
+			const int32 NumCooldownsStarted = Ability->NumCooldownsStarted;
+
+			TestTrue(TEXT("Restored"), Component->RestoreSnapshot(Data));
+			TestEqual(TEXT("Buff count"), Component->GetBuffCount(Buff), 2);
+			TestEqual(TEXT("Buff magnitude"), Component->GetBuffSpec(Buff).Magnitude, 2.f);
+			TestFalse(TEXT("Has later buff"), Component->HasBuff(OtherBuff));
+			TestEqual(TEXT("Buff lifetime"), Component->GetBuffRemainingLifetime(Buff), 0.6f, 0.01f);
+
+			const FReplicatedBuff* Item = Component->GetReplicatedBuffs().GetItems().FindByPredicate([Buff](const FReplicatedBuff& Other)
+			{
+				return Other.Buff == Buff;
+			});
+			TestTrue(TEXT("Replicated magnitude"), Item && Item->Magnitude == 2.f);
+
+			TestTrue(TEXT("Is cooling down"), Ability->IsCoolingDown());
+			TestEqual(TEXT("Cooldown remaining"), Component->GetRemainingCooldown(UTestAbility_Cooldown::StaticClass()), 0.6f, 0.01f);
+			TestEqual(TEXT("Cooldown notified"), Ability->NumCooldownsStarted, NumCooldownsStarted + 1);
+
+			GetWorld()->Tick(LEVELTICK_All, 0.1f);
+			TestEqual(TEXT("Buff notifications"), NumBuffsChanged, 1);
+			TestEqual(TEXT("Tag notifications"), NumTagsDeltas, 1);
+			TestFalse(TEXT("Has later tag"), Component->GetTags().HasTagExact(FAbilitiesTestTags::B));
+
+			GetWorld()->Tick(LEVELTICK_All, 0.6f);
+			TestFalse(TEXT("Has buff after restored lifetime"), Component->HasBuff(Buff));
+
+			Component->OnTagsDelta.Clear();
+			Component->OnBuffsChanged.Clear();
+			Buff->RemoveFromRoot();
+			OtherBuff->RemoveFromRoot();
+			RemoveTestComponent(Component);
+		});
+
+		It("Rejects truncated or corrupted snapshots", [this]()
+		{
+			UAbilitiesComponent* Component = AddTestComponent();
+			UTestBuff* Buff = NewObject<UTestBuff>();
+			Buff->AddToRoot();
+
+			Component->EquipAbility<UTestAbility>();
+			Component->ApplyBuff(Buff);
+			Component->AddTag(FAbilitiesTestTags::A);
+
+			TArray<uint8> Data;
+			Component->CaptureSnapshot(Data);
+			Component->RemoveBuff(Buff);
+
+			// Reading past the end of the data is logged
+			AddExpectedError(TEXT("bytes remain"), EAutomationExpectedErrorFlags::Contains, 0);
+			for (int32 Num = 0; Num < Data.Num(); ++Num)
+			{
+				const TArray<uint8> Truncated{ Data.GetData(), Num };
+				if (Component->RestoreSnapshot(Truncated))
+				{
+					AddError(FString::Printf(TEXT("Restored a snapshot truncated to %d bytes"), Num));
+					break;
+				}
+			}
+
+			// Magic, version and number of strings
+			auto Corrupt = [&Data](int32 Offset, int32 Value)
+			{
+				TArray<uint8> Corrupted = Data;
+				FMemory::Memcpy(Corrupted.GetData() + Offset, &Value, sizeof(Value));
+				return Corrupted;
+			};
+			TestFalse(TEXT("Restored wrong magic"), Component->RestoreSnapshot(Corrupt(0, 0)));
+			TestFalse(TEXT("Restored newer version"), Component->RestoreSnapshot(Corrupt(4, FAbilitiesSnapshot::Latest + 1)));
+			TestFalse(TEXT("Restored too many strings"), Component->RestoreSnapshot(Corrupt(8, MAX_int32)));
+			TestFalse(TEXT("Restored negative strings"), Component->RestoreSnapshot(Corrupt(8, -1)));
+			TestFalse(TEXT("Has buff"), Component->HasBuff(Buff));
+
+			TestTrue(TEXT("Restored intact data"), Component->RestoreSnapshot(Data));
+			TestTrue(TEXT("Has buff after intact data"), Component->HasBuff(Buff));
+
+			Buff->RemoveFromRoot();
+			RemoveTestComponent(Component);
+		});
+
+		It("Keeps unchanged buffs applied", [this]()
+		{
+			UAbilitiesComponent* Component = AddTestComponent();
+			UTestBuff* Buff = NewObject<UTestBuff>();
+			Buff->AddToRoot();
+
+			Component->ApplyBuff(Buff);
+			TArray<uint8> Data;
+			Component->CaptureSnapshot(Data);
+
+			const int32 NumApplied = Buff->NumEventApplyEffects;
+			TestTrue(TEXT("Restored"), Component->RestoreSnapshot(Data));
+			TestEqual(TEXT("Buff count"), Component->GetBuffCount(Buff), 1);
+			TestEqual(TEXT("Effects applied again"), Buff->NumEventApplyEffects, NumApplied);
+
+			Buff->RemoveFromRoot();
+			RemoveTestComponent(Component);
+		});
+
+		It("Replaces a running cooldown without notifying it ready", [this]()
+		{
+			UAbilitiesComponent* Component = AddTestComponent();
+			Component->EquipAbility<UTestAbility_Cooldown>();
+			auto* Ability = Cast<UTestAbility_Cooldown>(Component->GetEquippedAbility(UTestAbility_Cooldown::StaticClass()));
+			Component->CastAbility<UTestAbility_Cooldown>();
+			Ability->Cancel();
+			GetWorld()->Tick(LEVELTICK_All, 0.2f);
+
+			TArray<uint8> Data;
+			Component->CaptureSnapshot(Data);
+			GetWorld()->Tick(LEVELTICK_All, 0.3f);
+
+			const int32 NumCooldownsStarted = Ability->NumCooldownsStarted;
+			const int32 NumCooldownsReady = Ability->NumCooldownsReady;
+			TestTrue(TEXT("Restored"), Component->RestoreSnapshot(Data));
+			TestEqual(TEXT("Cooldown remaining"), Component->GetRemainingCooldown(UTestAbility_Cooldown::StaticClass()), 0.8f, 0.01f);
+			TestEqual(TEXT("Cooldown started"), Ability->NumCooldownsStarted, NumCooldownsStarted);
+			TestEqual(TEXT("Cooldown ready"), Ability->NumCooldownsReady, NumCooldownsReady);
+
+			RemoveTestComponent(Component);
+		});
+
+		It("Skips tags of buffs that are not loaded", [this]()
+		{
+			UAbilitiesComponent* Component = AddTestComponent();
+			UTestBuff* Buff = NewObject<UTestBuff>();
+			Buff->AddToRoot();
+			Buff->SetTagChanges(FGameplayTagContainer{ FAbilitiesTestTags::A }, {});
+
+			Component->ApplyBuff(Buff);
+			Component->AddTag(FAbilitiesTestTags::B);
+			TArray<uint8> Data;
+			Component->CaptureSnapshot(Data);
+
+			// The captured path doesn't resolve anymore
+			Component->RemoveBuff(Buff);
+			Buff->Rename(nullptr, nullptr, REN_DontCreateRedirectors);
+
+			TestTrue(TEXT("Restored"), Component->RestoreSnapshot(Data));
+			TestFalse(TEXT("Has buff"), Component->HasBuff(Buff));
+			TestFalse(TEXT("Has tag of the buff"), Component->GetTags().HasTagExact(FAbilitiesTestTags::A));
+			TestTrue(TEXT("Has captured tag"), Component->GetTags().HasTagExact(FAbilitiesTestTags::B));
+
+			Buff->RemoveFromRoot();
+			RemoveTestComponent(Component);
+		});
+
+		AfterEach([this]()
+		{
+			ShutdownWorld();
+		});
+	});
 }
 
 #endif //WITH_DEV_AUTOMATION_TESTS
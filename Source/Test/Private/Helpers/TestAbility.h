@@ -16,6 +16,11 @@ class ABILITIESTEST_API UTestAbility : public UAbility
 public:
 
 	bool bCalledBeginPlay = false;
+	int32 NumTagsChanged = 0;
+	FAbilityTagsDelta LastTagsDelta;
+
+	// Calls to the native override of the Blueprint event
+	int32 NumEventActivate = 0;
 
 	UPROPERTY()
 	bool bEnableActivation = true;
@@ -47,6 +52,25 @@ protected:
 	{
 		OnTick.Broadcast();
 	}
+
+	virtual void EventActivate_Implementation(const FStructContainer& Container) override
+	{
+		++NumEventActivate;
+		Super::EventActivate_Implementation(Container);
+	}
+
+public:
+
+	virtual void OnTagsChanged(const FGameplayTagContainer& Tags) override
+	{
+		Super::OnTagsChanged(Tags);
+		++NumTagsChanged;
+	}
+
+	virtual void OnTagsDelta(const FAbilityTagsDelta& Delta) override
+	{
+		LastTagsDelta = Delta;
+	}
 };
 
 
@@ -86,4 +110,63 @@ public:
 		Super::OnActivation(Container);
 		Deactivate();
 	}
-};
\ No newline at end of file
+};
+
+UCLASS(NotBlueprintable, NotBlueprintType)
+class ABILITIESTEST_API UTestAbility_Cooldown : public UAbility
+{
+	GENERATED_BODY()
+
+public:
+
+	int32 NumCooldownsStarted = 0;
+	int32 NumCooldownsReady = 0;
+
+
+	UTestAbility_Cooldown() : Super()
+	{
+		bHasCast = false;
+		bHasCooldown = true;
+		CooldownDuration = 1.f;
+	}
+
+	virtual void OnCooldownStarted() override
+	{
+		++NumCooldownsStarted;
+	}
+
+	virtual void OnCooldownReady(ECooldownReadyReason Reason) override
+	{
+		++NumCooldownsReady;
+	}
+};
+
+UCLASS(NotBlueprintable, NotBlueprintType)
+class ABILITIESTEST_API UTestAbility_Interrupt : public UAbility
+{
+	GENERATED_BODY()
+
+public:
+
+	UTestAbility_Interrupt() : Super()
+	{
+		bHasCast = false;
+		bInterruptionCancelsActivation = true;
+	}
+
+	int32 NumStateChanges = 0;
+
+
+	void SetInterruptTags(const FGameplayTagContainer& InTags)
+	{
+		InterruptWithTags = InTags;
+	}
+
+protected:
+
+	virtual void OnStateChanged(FAbilityStateTransition Transition, const FStructContainer& Container) override
+	{
+		Super::OnStateChanged(Transition, Container);
+		++NumStateChanges;
+	}
+};
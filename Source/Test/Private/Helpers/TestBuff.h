@@ -5,6 +5,7 @@
 #include <CoreMinimal.h>
 
 #include "Buff.h"
+#include "TestTags.h"
 #include "TestBuff.generated.h"
 
 
@@ -18,8 +19,78 @@ public:
 	mutable bool bChangesApplied = false;
 	mutable int32 LastCount;
 
+	// State of the component seen while reverting
+	mutable int32 CountWhileReverting = 0;
+	mutable float MagnitudeWhileReverting = 0.f;
+
+	// Calls to the native override of the Blueprint event
+	mutable int32 NumEventApplyEffects = 0;
+
+	mutable int32 NumStackDeltas = 0;
+	mutable int32 NumPeriods = 0;
+
+
+	// Setup before the buff is first applied
+	void SetStackable() { bStackable = true; }
+
+	void SetLifetime(float Duration)
+	{
+		bHasLifetime = true;
+		LifetimeDuration = Duration;
+	}
+
+	void SetStackLifetime(float Duration)
+	{
+		SetStackable();
+		SetLifetime(Duration);
+		bPerStackLifetime = true;
+	}
+
+	void SetPeriod(float InPeriod) { Period = InPeriod; }
+
+	// Stack changes only update the count instead of reverting and applying effects again
+	void SetOnlyStackDelta()
+	{
+		SetStackable();
+		bOnlyStackDelta = true;
+	}
+
+	void SetReplication(EBuffReplicationPolicy InReplication) { Replication = InReplication; }
+
+	void SetTags(const FGameplayTagContainer& InTags) { Tags = InTags; }
+
+	void SetTagChanges(const FGameplayTagContainer& InTagsToApply, const FGameplayTagContainer& InRemoveTagsOnApply)
+	{
+		TagsToApply = InTagsToApply;
+		RemoveTagsOnApply = InRemoveTagsOnApply;
+	}
+
+	void SetStackingGroup(FGameplayTag Group, EBuffStackingPolicy Policy)
+	{
+		StackingGroup = Group;
+		StackingPolicy = Policy;
+	}
+
+	void AddModifier(EAttributeModifierOp Operation, float Magnitude)
+	{
+		FAttributeModifier Modifier;
+		Modifier.Attribute = FAbilitiesTestTags::A;
+		Modifier.Operation = Operation;
+		Modifier.Magnitude = Magnitude;
+		Modifiers.Add(Modifier);
+	}
+
 protected:
 
+	bool bOnlyStackDelta = false;
+
+
+	virtual void EventApplyEffects_Implementation(UAbilitiesComponent* Component, int32 Count) const override
+	{
+		++NumEventApplyEffects;
+		Super::EventApplyEffects_Implementation(Component, Count);
+	}
+
 	virtual void ApplyEffects(UAbilitiesComponent* Component, int32 Count) const override
 	{
 		bChangesApplied = true;
@@ -30,6 +101,26 @@ protected:
 	{
 		bChangesApplied = false;
 		LastCount = Count;
+		CountWhileReverting = Component->GetBuffCount(this);
+		MagnitudeWhileReverting = Component->GetBuffSpec(this).Magnitude;
+	}
+
+	virtual void ApplyStackDelta(UAbilitiesComponent* Component, int32 OldCount, int32 NewCount) const override
+	{
+		++NumStackDeltas;
+		if (bOnlyStackDelta)
+		{
+			LastCount = NewCount;
+		}
+		else
+		{
+			Super::ApplyStackDelta(Component, OldCount, NewCount);
+		}
+	}
+
+	virtual void OnPeriod(UAbilitiesComponent* Component, int32 Count) const override
+	{
+		++NumPeriods;
 	}
 };
 
@@ -66,4 +157,4 @@ class ABILITIESTEST_API UTestBuff_Stackable : public UTestBuff
 	{
 		bStackable = true;
 	}
-};
\ No newline at end of file
+};
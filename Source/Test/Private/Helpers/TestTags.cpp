@@ -0,0 +1,19 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include "TestTags.h"
+#include <GameplayTagsManager.h>
+
+
+FGameplayTag FAbilitiesTestTags::Parent;
+FGameplayTag FAbilitiesTestTags::A;
+FGameplayTag FAbilitiesTestTags::B;
+FGameplayTag FAbilitiesTestTags::Other;
+
+void FAbilitiesTestTags::AddNativeTags()
+{
+	UGameplayTagsManager& Manager = UGameplayTagsManager::Get();
+	Parent = Manager.AddNativeGameplayTag(TEXT("AbilitiesTest.Tag"));
+	A      = Manager.AddNativeGameplayTag(TEXT("AbilitiesTest.Tag.A"));
+	B      = Manager.AddNativeGameplayTag(TEXT("AbilitiesTest.Tag.B"));
+	Other  = Manager.AddNativeGameplayTag(TEXT("AbilitiesTest.Other"));
+}
@@ -0,0 +1,18 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#pragma once
+
+#include <CoreMinimal.h>
+#include <GameplayTagContainer.h>
+
+
+// Native gameplay tags registered by the test module
+struct FAbilitiesTestTags
+{
+	static FGameplayTag Parent;
+	static FGameplayTag A;
+	static FGameplayTag B;
+	static FGameplayTag Other;
+
+	static void AddNativeTags();
+};
@@ -8,6 +8,6 @@ class FAbilitiesTestModule : public IModuleInterface
 {
 public:
 
-	virtual void StartupModule() override {}
+	virtual void StartupModule() override;
 	virtual void ShutdownModule() override {}
 };